@@ -0,0 +1,31 @@
+#include "Misc/AutomationTest.h"
+#include "WakaTimeHeartbeatDedup.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWakaTimeHeartbeatDedupTest, "WakaTimeForUE.HeartbeatDedup",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FWakaTimeHeartbeatDedupTest::RunTest(const FString& Parameters)
+{
+	FWakaTimeHeartbeatDedup Dedup(2);
+	const FString Blueprint = TEXT("/Game/Blueprints/BP_Car");
+
+	TestTrue(TEXT("First heartbeat"), Dedup.ShouldSend("coding", Blueprint, false, 1000.0));
+	TestFalse(TEXT("Same entity within two minutes"), Dedup.ShouldSend("coding", Blueprint, false, 1100.0));
+	TestTrue(TEXT("Two minutes after the last one sent"), Dedup.ShouldSend("coding", Blueprint, false, 1120.0));
+	TestTrue(TEXT("is_write changed"), Dedup.ShouldSend("coding", Blueprint, true, 1125.0));
+	TestTrue(TEXT("Other category"), Dedup.ShouldSend("designing", Blueprint, true, 1125.0));
+
+	// A debounced heartbeat carries the time of its last event, which can be before the last one sent
+	TestFalse(TEXT("Window applies both ways"), Dedup.ShouldSend("designing", Blueprint, true, 1010.0));
+
+	// Capacity is two: the "coding" entry is the least recently used and goes first
+	TestTrue(TEXT("Third key"), Dedup.ShouldSend("coding", TEXT("Unreal Engine"), false, 1130.0));
+	TestTrue(TEXT("Evicted entity is sent again"), Dedup.ShouldSend("coding", Blueprint, true, 1130.0));
+
+	TestEqual(TEXT("Hit rate"), Dedup.GetHitRate(), 2.0 / 8.0);
+	return true;
+}
+
+#endif
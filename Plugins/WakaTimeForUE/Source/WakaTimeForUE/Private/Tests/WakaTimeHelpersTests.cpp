@@ -0,0 +1,69 @@
+#include "Misc/AutomationTest.h"
+#include "WakaTimeHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWakaTimeQuoteArgumentTest, "WakaTimeForUE.Helpers.QuoteArgument",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FWakaTimeQuoteArgumentTest::RunTest(const FString& Parameters)
+{
+	// Expected results follow CommandLineToArgvW: backslashes are literal unless they precede a quote
+	struct FCase
+	{
+		const char* Input;
+		const char* Expected;
+	};
+	const FCase Cases[] = {
+		{"--entity", "--entity"},
+		{"", "\"\""},
+		{"C:\\Program Files\\Epic", "\"C:\\Program Files\\Epic\""},
+		{"C:\\Projects\\", "C:\\Projects\\"},
+		{"C:\\My Projects\\", "\"C:\\My Projects\\\\\""},
+		{"say \"hi\"", "\"say \\\"hi\\\"\""},
+		{"a\\\"b", "\"a\\\\\\\"b\""},
+		{"tab\there", "\"tab\there\""},
+	};
+
+	for (const FCase& Case : Cases)
+	{
+		std::string Quoted = FWakaTimeHelpers::QuoteArgument(Case.Input);
+		TestEqual(FString::Printf(TEXT("QuoteArgument(%s)"), UTF8_TO_TCHAR(Case.Input)),
+		          FString(UTF8_TO_TCHAR(Quoted.c_str())), FString(UTF8_TO_TCHAR(Case.Expected)));
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWakaTimeAppendJsonStringTest, "WakaTimeForUE.Helpers.AppendJsonString",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FWakaTimeAppendJsonStringTest::RunTest(const FString& Parameters)
+{
+	struct FCase
+	{
+		std::string Input;
+		const char* Expected;
+	};
+	const FCase Cases[] = {
+		{"Main.umap", "\"Main.umap\""},
+		{"", "\"\""},
+		{"say \"hi\"", "\"say \\\"hi\\\"\""},
+		{"C:\\Projects", "\"C:\\\\Projects\""},
+		{"line\nbreak\r\ttab", "\"line\\nbreak\\r\\ttab\""},
+		{std::string("nul\0bell\x07", 9), "\"nul\\u0000bell\\u0007\""},
+		{"\x1f", "\"\\u001f\""},
+		// UTF-8 passes through untouched
+		{"\xc3\xa9t\xc3\xa9", "\"\xc3\xa9t\xc3\xa9\""},
+	};
+
+	for (const FCase& Case : Cases)
+	{
+		std::string Json = "prefix:";
+		FWakaTimeHelpers::AppendJsonString(Json, Case.Input);
+		TestEqual(FString::Printf(TEXT("AppendJsonString(%s)"), UTF8_TO_TCHAR(Case.Expected)),
+		          FString(UTF8_TO_TCHAR(Json.c_str())), FString(UTF8_TO_TCHAR((std::string("prefix:") + Case.Expected).c_str())));
+	}
+	return true;
+}
+
+#endif
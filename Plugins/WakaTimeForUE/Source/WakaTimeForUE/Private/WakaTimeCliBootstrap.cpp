@@ -0,0 +1,166 @@
+#include "WakaTimeCliBootstrap.h"
+
+#include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "HttpModule.h"
+#include "Interfaces/IHttpResponse.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Guid.h"
+#include "Misc/Paths.h"
+#include "WakaTimeForUE.h"
+#if ENGINE_MAJOR_VERSION >= 5 && ENGINE_MINOR_VERSION >= 1
+#include "FileUtilities/ZipArchiveReader.h"
+#else // FZipArchiveReader was added in UE5.1
+#include "WakaTimeHelpers.h"
+#endif
+#if PLATFORM_UNIX || PLATFORM_MAC
+#include <sys/stat.h>
+#endif
+
+static TAutoConsoleVariable<FString> CVarWakaTimeCliDownloadUrl(
+	TEXT("WakaTime.CliDownloadUrl"),
+	TEXT(""),
+	TEXT("Overrides where a missing wakatime-cli is installed from (http(s):// or file:// URL of a release zip). ")
+	TEXT("Read once at startup."));
+
+void FWakaTimeCliBootstrap::Start(const std::string& InCliPath, const FString& Url, FOnFinished InOnFinished)
+{
+	CliPath = UTF8_TO_TCHAR(InCliPath.c_str());
+	OnFinished = MoveTemp(InOnFinished);
+	AliveToken = MakeShared<bool, ESPMode::ThreadSafe>(true);
+	WeakAliveToken = AliveToken;
+
+	UE_LOG(LogWakaTime, Log, TEXT("Installing wakatime-cli from %s in the background"), *Url);
+
+	if (Url.StartsWith(TEXT("file://")))
+	{
+		FString ZipPath = Url.RightChop(7);
+		InstallTask = Async(EAsyncExecution::ThreadPool, [this, ZipPath]()
+		{
+			Finish(Install(ZipPath, false));
+		});
+		return;
+	}
+
+	Request = FHttpModule::Get().CreateRequest();
+	Request->SetURL(Url);
+	Request->SetVerb(TEXT("GET"));
+	Request->OnProcessRequestComplete().BindRaw(this, &FWakaTimeCliBootstrap::OnDownloadComplete);
+	Request->ProcessRequest();
+}
+
+void FWakaTimeCliBootstrap::Shutdown()
+{
+	AliveToken.Reset();
+
+	if (Request.IsValid())
+	{
+		Request->OnProcessRequestComplete().Unbind();
+		Request->CancelRequest();
+		Request.Reset();
+	}
+
+	if (InstallTask.IsValid())
+	{
+		InstallTask.Wait();
+	}
+}
+
+FString FWakaTimeCliBootstrap::GetDownloadUrl(const std::string& OS, const std::string& Architecture)
+{
+	FString Override = CVarWakaTimeCliDownloadUrl.GetValueOnGameThread();
+	if (!Override.IsEmpty())
+	{
+		return Override;
+	}
+
+	return FString::Printf(TEXT("https://github.com/wakatime/wakatime-cli/releases/latest/download/wakatime-cli-%s-%s.zip"),
+	                       UTF8_TO_TCHAR(OS.c_str()), UTF8_TO_TCHAR(Architecture.c_str()));
+}
+
+void FWakaTimeCliBootstrap::OnDownloadComplete(FHttpRequestPtr HttpRequest, FHttpResponsePtr Response, bool bSucceeded)
+{
+	Request.Reset();
+
+	if (!bSucceeded || !Response.IsValid() || Response->GetResponseCode() != 200)
+	{
+		UE_LOG(LogWakaTime, Error, TEXT("Error downloading wakatime-cli (code %d). Please, install it manually."),
+		       Response.IsValid() ? Response->GetResponseCode() : 0);
+		Finish(false);
+		return;
+	}
+
+	UE_LOG(LogWakaTime, Log, TEXT("Successfully downloaded wakatime-cli.zip"));
+
+	// Writing and unpacking ~10 MB doesn't belong on the game thread
+	InstallTask = Async(EAsyncExecution::ThreadPool, [this, Response]()
+	{
+		FString ZipPath = FPaths::GetPath(CliPath) / FString::Printf(TEXT("wakatime-cli.%s.zip"), *FGuid::NewGuid().ToString());
+		bool bSaved = FFileHelper::SaveArrayToFile(Response->GetContent(), *ZipPath);
+		Finish(bSaved && Install(ZipPath, true));
+	});
+}
+
+bool FWakaTimeCliBootstrap::Install(const FString& ZipPath, bool bDeleteZip) const
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	FString EntryName = FPaths::GetCleanFilename(CliPath);
+	FString TempCliPath = CliPath + TEXT(".") + FGuid::NewGuid().ToString() + TEXT(".tmp");
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(CliPath));
+
+	bool bExtracted = false;
+#if ENGINE_MAJOR_VERSION >= 5 && ENGINE_MINOR_VERSION >= 1
+	if (IFileHandle* ZipHandle = PlatformFile.OpenRead(*ZipPath))
+	{
+		FZipArchiveReader Reader(ZipHandle); // takes ownership of the handle
+		TArray<uint8> CliData;
+		bExtracted = Reader.IsValid() && Reader.TryReadFile(EntryName, CliData) &&
+			FFileHelper::SaveArrayToFile(CliData, *TempCliPath);
+	}
+#else
+	FString TempDirectory = TempCliPath + TEXT(".d");
+	bExtracted = FWakaTimeHelpers::UnzipArchive(TCHAR_TO_UTF8(*ZipPath), TCHAR_TO_UTF8(*TempDirectory)) &&
+		PlatformFile.MoveFile(*TempCliPath, *(TempDirectory / EntryName));
+	PlatformFile.DeleteDirectoryRecursively(*TempDirectory);
+#endif
+
+	if (bDeleteZip)
+	{
+		PlatformFile.DeleteFile(*ZipPath);
+	}
+
+	if (!bExtracted)
+	{
+		UE_LOG(LogWakaTime, Error, TEXT("Could not extract %s from %s"), *EntryName, *ZipPath);
+		PlatformFile.DeleteFile(*TempCliPath);
+		return false;
+	}
+
+#if PLATFORM_UNIX || PLATFORM_MAC
+	chmod(TCHAR_TO_UTF8(*TempCliPath), 0755);
+#endif
+
+	// The rename is atomic, so nobody ever runs a partially written CLI. If it fails because another editor
+	// installed the CLI in the meantime, that one is just as good
+	if (!PlatformFile.MoveFile(*CliPath, *TempCliPath))
+	{
+		PlatformFile.DeleteFile(*TempCliPath);
+		return PlatformFile.FileExists(*CliPath);
+	}
+
+	UE_LOG(LogWakaTime, Log, TEXT("Successfully extracted wakatime-cli."));
+	return true;
+}
+
+void FWakaTimeCliBootstrap::Finish(bool bSuccess)
+{
+	TWeakPtr<bool, ESPMode::ThreadSafe> WeakAlive = WeakAliveToken;
+	AsyncTask(ENamedThreads::GameThread, [this, WeakAlive, bSuccess]()
+	{
+		if (WeakAlive.IsValid() && OnFinished)
+		{
+			OnFinished(bSuccess);
+		}
+	});
+}
@@ -2,16 +2,18 @@
 // ReSharper disable CppLocalVariableMayBeConst
 #include "WakaTimeForUE.h"
 
-#include "Windows/AllowWindowsPlatformTypes.h"
 #include "GeneralProjectSettings.h"
 #include "LevelEditor.h"
 #include "WakaTimeHelpers.h"
+#include "WakaTimeStats.h"
 #include "Styling/SlateStyleRegistry.h"
 #include <Editor/MainFrame/Public/Interfaces/IMainFrameModule.h>
-#include <activation.h>
 #include <fstream>
 
 #include "BlueprintEditorModule.h"
+#include "DirectoryWatcherModule.h"
+#include "IDirectoryWatcher.h"
+#include "HAL/IConsoleManager.h"
 #include "Interfaces/IPluginManager.h"
 #include "UObject/ObjectSaveContext.h"
 
@@ -20,12 +22,11 @@ using namespace std;
 #define LOCTEXT_NAMESPACE "FWakaTimeForUEModule"
 
 // Global variables
-string GAPIKey("");
-string GAPIUrl("");
-string GBaseCommand("");
+string GWakaCliPath("");
 string GUserProfile;
 string GProjectPath;
 string GPluginVersion;
+string GWakatimeOS;
 string GWakatimeArchitecture;
 string GWakaCliVersion;
 
@@ -38,74 +39,89 @@ FDelegateHandle PostSaveWorldHandle;
 FDelegateHandle GPostPieStartedHandle;
 FDelegateHandle GPrePieEndedHandle;
 FDelegateHandle OnBlueprintPreCompileHandle;
+FDelegateHandle OnBlueprintCompiledHandle;
 FDelegateHandle OnEditorInitializedHandle;
 #if ENGINE_MAJOR_VERSION >= 5 && ENGINE_MINOR_VERSION >= 4 // RedTheKitsune(OnAssetClosedInEditor is not available in <UE5.4, so blueprint name tracking will not work properly)
 FDelegateHandle OnAssetOpenedInEditorHandle;
 FDelegateHandle OnAssetClosedInEditorHandle;
 #endif
 
-// UI Elements
-TSharedRef<SEditableTextBox> GAPIKeyBlock = SNew(SEditableTextBox)
-.Text(FText::FromString(FString(UTF8_TO_TCHAR(GAPIKey.c_str())))).MinDesiredWidth(500);
-TSharedRef<SEditableTextBox> GAPIUrlBlock = SNew(SEditableTextBox)
-.Text(FText::FromString(FString(UTF8_TO_TCHAR(GAPIUrl.c_str())))).MinDesiredWidth(500);
-TSharedRef<SWindow> SettingsWindow = SNew(SWindow);
+FDelegateHandle ConfigDirectoryChangedHandle;
+
+// UI Elements; created when first needed, not when the module is loaded
+TSharedPtr<SEditableTextBox> GAPIKeyBlock;
+TSharedPtr<SEditableTextBox> GAPIUrlBlock;
+TSharedPtr<SWindow> SettingsWindow;
 TSharedPtr<FSlateStyleSet> StyleSetInstance = nullptr;
 
 
 DEFINE_LOG_CATEGORY(LogWakaTime);
 
+static TAutoConsoleVariable<float> CVarWakaTimePieHeartbeatInterval(
+	TEXT("WakaTime.PieHeartbeatInterval"),
+	120.0f,
+	TEXT("Seconds between debugging heartbeats while Play-In-Editor runs. Read when a session starts."));
+
+// How much longer editor events are merged while the plugin is over its frame budget
+const float DegradedDebounceScale = 4.0f;
+
+// Heartbeat processes allowed to run at once, and heartbeats allowed to wait for one
+const int32 MaxConcurrentHeartbeats = 2;
+const int32 MaxQueuedHeartbeats = 64;
+
 // Module methods
 void FWakaTimeForUEModule::StartupModule()
 {
 	AssignGlobalVariables();
 
-	FString WakatimeCliFilePath = FString(GUserProfile.c_str()) + TEXT("\\.wakatime\\") + FString(GWakaCliVersion.c_str());
-	
-	// testing for "wakatime-cli.exe" which is used by most IDEs
-	if (FPlatformFileManager::Get().GetPlatformFile().FileExists(*WakatimeCliFilePath))
+	// TheAshenWolf(Wakatime-cli.exe is not in the path by default, which is why we have to use the user path)
+	GWakaCliPath = GUserProfile + "/.wakatime/" + GWakaCliVersion;
+
+	HeartbeatQueue.Start(GWakaCliPath, MaxConcurrentHeartbeats, MaxQueuedHeartbeats,
+	                     [this](bool bSuccess, uint32 ErrorCode, int32 NumHeartbeats)
+	                     {
+		                     OnHeartbeatFinished(bSuccess, ErrorCode, NumHeartbeats);
+	                     }, &HttpTransport);
+
+	HeartbeatScheduler.Initialize([this](bool bIsWrite, const string& Activity, const string& EntityType,
+	                                     const FString& Entity, const string& Language, double Time)
+	{
+		SendHeartbeat(bIsWrite, Activity, EntityType, Entity, Language, Time);
+	});
+
+	FrameBudget.Initialize([this](bool bDegraded)
+	{
+		HeartbeatScheduler.SetWindowScale(bDegraded ? DegradedDebounceScale : 1.0f);
+	});
+
+	// testing for "wakatime-cli-<os>-<arch>" which is used by most IDEs
+	if (FWakaTimeHelpers::PathExists(GWakaCliPath))
 	{
 		UE_LOG(LogWakaTime, Log, TEXT("Found IDE wakatime-cli"));
-		GBaseCommand = (string(GUserProfile) + "\\.wakatime\\" + GWakaCliVersion);
 	}
 	else
 	{
-		// neither way was found; download and install the new version
+		// neither way was found; download and install the new version without holding up the editor
 		UE_LOG(LogWakaTime, Log, TEXT("Did not find wakatime"));
-		GBaseCommand = "/c start \"\" /b \"" + string(GUserProfile) + "\\.wakatime\\" +
-			GWakaCliVersion + "\"";
-		string FolderPath = string(GUserProfile) + "\\.wakatime";
-		if (!FWakaTimeHelpers::PathExists(FolderPath))
-		{
-			FWakaTimeHelpers::RunCmdCommand("mkdir " + FolderPath, false, INFINITE);
-		}
-		DownloadWakatimeCli(string(GUserProfile) + "\\.wakatime\\wakatime-cli\\" + GWakaCliVersion);
+		DownloadWakatimeCli(GWakaCliPath);
 	}
-	// TheAshenWolf(Wakatime-cli.exe is not in the path by default, which is why we have to use the user path)
 
+	string ConfigFileDir = GUserProfile + "/.wakatime.cfg";
+	HandleStartupApiCheck(ConfigFileDir);
 
-	if (!StyleSetInstance.IsValid())
+	// The config is parsed once; afterwards it is only re-read when the file changes on disk
+	FDirectoryWatcherModule& DirectoryWatcherModule =
+		FModuleManager::LoadModuleChecked<FDirectoryWatcherModule>(TEXT("DirectoryWatcher"));
+	if (IDirectoryWatcher* DirectoryWatcher = DirectoryWatcherModule.Get())
 	{
-		StyleSetInstance = CreateToolbarIcon();
-		FSlateStyleRegistry::RegisterSlateStyle(*StyleSetInstance);
+		DirectoryWatcher->RegisterDirectoryChangedCallback_Handle(
+			UTF8_TO_TCHAR(GUserProfile.c_str()),
+			IDirectoryWatcher::FDirectoryChanged::CreateRaw(this, &FWakaTimeForUEModule::OnConfigDirectoryChanged),
+			ConfigDirectoryChangedHandle, IDirectoryWatcher::WatchOptions::IgnoreChangesInSubtree);
 	}
 
-	string ConfigFileDir = string(GUserProfile) + "\\.wakatime.cfg";
-	HandleStartupApiCheck(ConfigFileDir);
-
 	// Add Listeners
-	NewActorsDroppedHandle = FEditorDelegates::OnNewActorsDropped.AddRaw(
-		this, &FWakaTimeForUEModule::OnNewActorDropped);
-	DeleteActorsEndHandle = FEditorDelegates::OnDeleteActorsEnd.AddRaw(this, &FWakaTimeForUEModule::OnDeleteActorsEnd);
-	DuplicateActorsEndHandle = FEditorDelegates::OnDuplicateActorsEnd.AddRaw(
-		this, &FWakaTimeForUEModule::OnDuplicateActorsEnd);
-	AddLevelToWorldHandle = FEditorDelegates::OnAddLevelToWorld.AddRaw(this, &FWakaTimeForUEModule::OnAddLevelToWorld);
-
-#if ENGINE_MAJOR_VERSION >= 5
-	PostSaveWorldHandle = FEditorDelegates::PostSaveWorldWithContext.AddRaw(this, &FWakaTimeForUEModule::OnPostSaveWorld);
-#else// TheAshenWolf(PostSaveWorld is deprecated as of UE5)
-	PostSaveWorldHandle = FEditorDelegates::PostSaveWorld.AddRaw(this, &FWakaTimeForUEModule::OnPostSaveWorld);
-#endif
+	BindEditorEvents();
 	
 	GPostPieStartedHandle = FEditorDelegates::PostPIEStarted.AddRaw(this, &FWakaTimeForUEModule::OnPostPieStarted);
 	GPrePieEndedHandle = FEditorDelegates::PrePIEEnded.AddRaw(this, &FWakaTimeForUEModule::OnPrePieEnded);
@@ -137,22 +153,45 @@ void FWakaTimeForUEModule::StartupModule()
 
 void FWakaTimeForUEModule::ShutdownModule()
 {
-	// Remove event handles
-	FEditorDelegates::OnNewActorsDropped.Remove(NewActorsDroppedHandle);
-	FEditorDelegates::OnDeleteActorsEnd.Remove(DeleteActorsEndHandle);
-	FEditorDelegates::OnDuplicateActorsEnd.Remove(DuplicateActorsEndHandle);
-	FEditorDelegates::OnAddLevelToWorld.Remove(AddLevelToWorldHandle);
+	HeartbeatScheduler.Shutdown();
+	CliBootstrap.Shutdown();
+	HeartbeatQueue.Shutdown();
+
+	if (FDirectoryWatcherModule* DirectoryWatcherModule =
+		FModuleManager::GetModulePtr<FDirectoryWatcherModule>(TEXT("DirectoryWatcher")))
+	{
+		if (IDirectoryWatcher* DirectoryWatcher = DirectoryWatcherModule->Get())
+		{
+			DirectoryWatcher->UnregisterDirectoryChangedCallback_Handle(UTF8_TO_TCHAR(GUserProfile.c_str()),
+			                                                            ConfigDirectoryChangedHandle);
+		}
+	}
+
+	if (StyleSetInstance.IsValid())
+	{
+		FSlateStyleRegistry::UnRegisterSlateStyle(*StyleSetInstance);
+		StyleSetInstance.Reset();
+	}
+
+	if (PieTickerHandle.IsValid())
+	{
 #if ENGINE_MAJOR_VERSION >= 5
-	FEditorDelegates::PostSaveWorldWithContext.Remove(PostSaveWorldHandle);
-#else // TheAshenWolf(PostSaveWorld is deprecated as of UE5)
-	FEditorDelegates::PostSaveWorld.Remove(PostSaveWorldHandle);
+		FTSTicker::GetCoreTicker().RemoveTicker(PieTickerHandle);
+#else
+		FTicker::GetCoreTicker().RemoveTicker(PieTickerHandle);
 #endif
+		PieTickerHandle.Reset();
+	}
+
+	// Remove event handles
+	UnbindEditorEvents();
 	FEditorDelegates::PostPIEStarted.Remove(GPostPieStartedHandle);
 	FEditorDelegates::PrePIEEnded.Remove(GPrePieEndedHandle);
 	
 	if (GEditor)
 	{
 		GEditor->OnBlueprintPreCompile().Remove(OnBlueprintPreCompileHandle);
+		GEditor->OnBlueprintCompiled().Remove(OnBlueprintCompiledHandle);
 
 #if ENGINE_MAJOR_VERSION >= 5 && ENGINE_MINOR_VERSION >= 4 // RedTheKitsune(OnAssetClosedInEditor is not available in <UE5.4, so blueprint name tracking will not work properly)
 		if (UAssetEditorSubsystem* AssetEditorSubsystem = GEditor->GetEditorSubsystem<UAssetEditorSubsystem>())
@@ -164,6 +203,40 @@ void FWakaTimeForUEModule::ShutdownModule()
 	}
 }
 
+void FWakaTimeForUEModule::BindEditorEvents()
+{
+	NewActorsDroppedHandle = FEditorDelegates::OnNewActorsDropped.AddRaw(
+		this, &FWakaTimeForUEModule::OnNewActorDropped);
+	DeleteActorsEndHandle = FEditorDelegates::OnDeleteActorsEnd.AddRaw(this, &FWakaTimeForUEModule::OnDeleteActorsEnd);
+	DuplicateActorsEndHandle = FEditorDelegates::OnDuplicateActorsEnd.AddRaw(
+		this, &FWakaTimeForUEModule::OnDuplicateActorsEnd);
+	AddLevelToWorldHandle = FEditorDelegates::OnAddLevelToWorld.AddRaw(this, &FWakaTimeForUEModule::OnAddLevelToWorld);
+
+#if ENGINE_MAJOR_VERSION >= 5
+	PostSaveWorldHandle = FEditorDelegates::PostSaveWorldWithContext.AddRaw(this, &FWakaTimeForUEModule::OnPostSaveWorld);
+#else// TheAshenWolf(PostSaveWorld is deprecated as of UE5)
+	PostSaveWorldHandle = FEditorDelegates::PostSaveWorld.AddRaw(this, &FWakaTimeForUEModule::OnPostSaveWorld);
+#endif
+}
+
+void FWakaTimeForUEModule::UnbindEditorEvents()
+{
+	FEditorDelegates::OnNewActorsDropped.Remove(NewActorsDroppedHandle);
+	FEditorDelegates::OnDeleteActorsEnd.Remove(DeleteActorsEndHandle);
+	FEditorDelegates::OnDuplicateActorsEnd.Remove(DuplicateActorsEndHandle);
+	FEditorDelegates::OnAddLevelToWorld.Remove(AddLevelToWorldHandle);
+#if ENGINE_MAJOR_VERSION >= 5
+	FEditorDelegates::PostSaveWorldWithContext.Remove(PostSaveWorldHandle);
+#else // TheAshenWolf(PostSaveWorld is deprecated as of UE5)
+	FEditorDelegates::PostSaveWorld.Remove(PostSaveWorldHandle);
+#endif
+	NewActorsDroppedHandle.Reset();
+	DeleteActorsEndHandle.Reset();
+	DuplicateActorsEndHandle.Reset();
+	AddLevelToWorldHandle.Reset();
+	PostSaveWorldHandle.Reset();
+}
+
 void FWakaCommands::RegisterCommands()
 {
 	UI_COMMAND(WakaTimeSettingsCommand, "Waka Time", "Waka time settings", EUserInterfaceActionType::Button,
@@ -174,25 +247,42 @@ void FWakaCommands::RegisterCommands()
 // Initialization methods
 void FWakaTimeForUEModule::AssignGlobalVariables()
 {
-	// use _dupenv_s instead of getenv, as it is safer
-	GUserProfile = "c:";
-	size_t LenDrive = 0;
-	char* envValue = nullptr;
+	// wakatime-cli looks for its config in %USERPROFILE% on Windows and $HOME elsewhere. Everything below uses
+	// forward slashes, which all platforms accept
+#if PLATFORM_WINDOWS
+	FString HomeDir = FPlatformMisc::GetEnvironmentVariable(TEXT("USERPROFILE"));
+#else
+	FString HomeDir = FPlatformProcess::UserHomeDir();
+#endif
+	GUserProfile = TCHAR_TO_UTF8(*HomeDir.Replace(TEXT("\\"), TEXT("/")));
+	if (GUserProfile.size() > 1 && GUserProfile.back() == '/')
+	{
+		GUserProfile.pop_back();
+	}
 
-	// Safely retrieve the USERPROFILE environment variable
-	_dupenv_s(&envValue, &LenDrive, "USERPROFILE");
+#if PLATFORM_WINDOWS
+	GWakatimeOS = "windows";
+#elif PLATFORM_MAC
+	GWakatimeOS = "darwin";
+#else
+	GWakatimeOS = "linux";
+#endif
 
-	// Check if the environment variable was retrieved successfully
-	if (envValue != nullptr) {
-		GUserProfile = envValue;  // Assign the value to GUserProfile
-		free(envValue);           // Free the allocated memory to prevent memory leaks
-	}
+	// The editor only ships 64-bit builds
+#if PLATFORM_CPU_ARM_FAMILY
+	GWakatimeArchitecture = "arm64";
+#else
+	GWakatimeArchitecture = "amd64";
+#endif
 
-	WCHAR BufferW[256];
-	GWakatimeArchitecture = GetSystemWow64DirectoryW(BufferW, 256) == 0 ? "386" : "amd64";
-	GWakaCliVersion = "wakatime-cli-windows-" + GWakatimeArchitecture + ".exe";
+	GWakaCliVersion = "wakatime-cli-" + GWakatimeOS + "-" + GWakatimeArchitecture;
+#if PLATFORM_WINDOWS
+	GWakaCliVersion += ".exe";
+#endif
 	
-	GProjectPath = TCHAR_TO_UTF8(*FPaths::ProjectDir().Replace(TEXT("/"), TEXT("\\")));
+	FString ProjectDir = FPaths::ConvertRelativePathToFull(FPaths::ProjectDir());
+	FPaths::MakePlatformFilename(ProjectDir);
+	GProjectPath = TCHAR_TO_UTF8(*ProjectDir);
 	
 	TSharedPtr<IPlugin> Plugin = IPluginManager::Get().FindPlugin(TEXT("WakaTimeForUE"));
 	GPluginVersion = TCHAR_TO_UTF8(*Plugin.Get()->GetDescriptor().VersionName);
@@ -207,24 +297,23 @@ void FWakaTimeForUEModule::HandleStartupApiCheck(string ConfigFilePath)
 		return;
 	}
 
-	bool bFoundApiKey = false;
-	bool bFoundApiUrl = false;
-	ReadConfig(ConfigFilePath, bFoundApiKey, bFoundApiUrl);
+	ReadConfig(ConfigFilePath);
 
-	if (!bFoundApiKey)
+	if (!Config.bFoundApiKey)
 	{
 		UE_LOG(LogWakaTime, Warning, TEXT("API key not found in config file"));
 		OpenSettingsWindow(); // if key was not found, open the settings
 	}
 
-	if (!bFoundApiUrl)
+	if (!Config.bFoundApiUrl)
 	{
 		UE_LOG(LogWakaTime, Warning, TEXT("API url not found in config file"));
 	}
 }
 
-void FWakaTimeForUEModule::ReadConfig(string ConfigFilePath, bool& bFoundApiKey, bool& bFoundApiUrl)
+void FWakaTimeForUEModule::ReadConfig(string ConfigFilePath)
 {
+	FWakaTimeConfig NewConfig;
 	string Line;
 	
 	fstream ConfigFile(ConfigFilePath);
@@ -233,30 +322,40 @@ void FWakaTimeForUEModule::ReadConfig(string ConfigFilePath, bool& bFoundApiKey,
 	{
 		if (Line.find("api_key") != string::npos)
 		{
-			GAPIKey = Line.substr(Line.find(" = ") + 3); // Pozitrone(Extract only the api key from the line);
-			GAPIKeyBlock.Get().SetText(FText::FromString(FString(UTF8_TO_TCHAR(GAPIKey.c_str()))));
-			bFoundApiKey = true;
+			NewConfig.ApiKey = Line.substr(Line.find(" = ") + 3); // Pozitrone(Extract only the api key from the line);
+			NewConfig.bFoundApiKey = true;
 		}
 
 		if (Line.find("api_url") != string::npos)
 		{
-			GAPIUrl = Line.substr(Line.find(" = ") + 3); // Pozitrone(Extract only the url key from the line);
-			GAPIUrlBlock.Get().SetText(FText::FromString(FString(UTF8_TO_TCHAR(GAPIUrl.c_str()))));
-			bFoundApiUrl = true;
+			NewConfig.ApiUrl = Line.substr(Line.find(" = ") + 3); // Pozitrone(Extract only the url key from the line);
+			NewConfig.bFoundApiUrl = true;
 		}
 	}
 
-	if(!bFoundApiKey)
-	{
-		GAPIKeyBlock.Get().SetText(FText::GetEmpty());
-	}
+	ConfigFile.close();
+
+	ApplyConfig(NewConfig);
+}
+
+void FWakaTimeForUEModule::ApplyConfig(const FWakaTimeConfig& NewConfig)
+{
+	Config = NewConfig;
+	HttpTransport.Configure(Config.ApiUrl, Config.ApiKey, GPluginVersion);
+}
 
-	if(!bFoundApiUrl)
+void FWakaTimeForUEModule::OnConfigDirectoryChanged(const TArray<FFileChangeData>& FileChanges)
+{
+	for (const FFileChangeData& FileChange : FileChanges)
 	{
-		GAPIUrlBlock.Get().SetText(FText::GetEmpty());
+		// Everything else in the home directory is none of our business
+		if (FPaths::GetCleanFilename(FileChange.Filename) == TEXT(".wakatime.cfg"))
+		{
+			UE_LOG(LogWakaTime, Log, TEXT("Config file changed, reloading"));
+			ReadConfig(GUserProfile + "/.wakatime.cfg");
+			return;
+		}
 	}
-
-	ConfigFile.close();
 }
 
 void FWakaTimeForUEModule::DownloadWakatimeCli(string CliPath)
@@ -269,27 +368,17 @@ void FWakaTimeForUEModule::DownloadWakatimeCli(string CliPath)
 
 	UE_LOG(LogWakaTime, Log, TEXT("CLI not found, attempting download."));
 
-	string URL = "https://github.com/wakatime/wakatime-cli/releases/latest/download/wakatime-cli-windows-" +
-		GWakatimeArchitecture + ".zip";
-
-	// Reference to the local path where the zip file will be downloaded (Under Name)
-	string LocalZipFilePath = string(GUserProfile) + "/.wakatime/" + "wakatime-cli.zip";
-
-	bool bSuccessDownload = FWakaTimeHelpers::DownloadFile(URL, LocalZipFilePath);
-
-	// Update the user about the new download (Success / Failure)
-	if (bSuccessDownload)
-	{
-		UE_LOG(LogWakaTime, Log, TEXT("Successfully downloaded wakatime-cli.zip"));
-		bool bSuccessUnzip = FWakaTimeHelpers::UnzipArchive(LocalZipFilePath,
-		                                                    string(GUserProfile) + "\\.wakatime");
-
-		if (bSuccessUnzip) UE_LOG(LogWakaTime, Log, TEXT("Successfully extracted wakatime-cli."));
-	}
-	else
-	{
-		UE_LOG(LogWakaTime, Error, TEXT("Error downloading wakatime-cli. Please, install it manually."));
-	}
+	// Heartbeats wait in the queue until there is a CLI to hand them to
+	HeartbeatQueue.Pause();
+	CliBootstrap.Start(CliPath, FWakaTimeCliBootstrap::GetDownloadUrl(GWakatimeOS, GWakatimeArchitecture),
+	                   [this](bool bSuccess)
+	                   {
+		                   if (!bSuccess)
+		                   {
+			                   UE_LOG(LogWakaTime, Error, TEXT("Error installing wakatime-cli. Please, install it manually."));
+		                   }
+		                   HeartbeatQueue.Resume();
+	                   });
 }
 
 string FWakaTimeForUEModule::GetProjectName()
@@ -327,6 +416,13 @@ TSharedRef<FSlateStyleSet> FWakaTimeForUEModule::CreateToolbarIcon()
 
 void FWakaTimeForUEModule::AddToolbarButton(FToolBarBuilder& Builder)
 {
+	// The style is only needed once the toolbar is actually built
+	if (!StyleSetInstance.IsValid())
+	{
+		StyleSetInstance = CreateToolbarIcon();
+		FSlateStyleRegistry::RegisterSlateStyle(*StyleSetInstance);
+	}
+
 	FSlateIcon Icon = FSlateIcon(TEXT("WakaTime2DStyle"), "mainIcon"); //Style.Get().GetStyleSetName(), "Icon128.png");
 
 	Builder.AddToolBarButton(FWakaCommands::Get().WakaTimeSettingsCommand, NAME_None, FText::FromString("WakaTime"),
@@ -336,15 +432,17 @@ void FWakaTimeForUEModule::AddToolbarButton(FToolBarBuilder& Builder)
 
 void FWakaTimeForUEModule::OpenSettingsWindowFromUI()
 {
-	bool bFoundApiKey = false;
-	bool bFoundApiUrl = false;
-	ReadConfig(string(GUserProfile) + "\\.wakatime.cfg", bFoundApiKey, bFoundApiUrl);
-
+	// No need to touch the disk; the cached config follows the file through the directory watcher
 	OpenSettingsWindow();
 }
 
 void FWakaTimeForUEModule::OpenSettingsWindow()
 {
+	GAPIKeyBlock = SNew(SEditableTextBox)
+		.Text(FText::FromString(FString(UTF8_TO_TCHAR(Config.ApiKey.c_str())))).MinDesiredWidth(500);
+	GAPIUrlBlock = SNew(SEditableTextBox)
+		.Text(FText::FromString(FString(UTF8_TO_TCHAR(Config.ApiUrl.c_str())))).MinDesiredWidth(500);
+
 	SettingsWindow = SNew(SWindow)
 		.Title(FText::FromString(TEXT("WakaTime Settings")))
 		.ClientSize(FVector2D(800, 400))
@@ -368,7 +466,7 @@ void FWakaTimeForUEModule::OpenSettingsWindow()
 			  .HAlign(HAlign_Center)
 			  .VAlign(VAlign_Center)
 			[
-				GAPIKeyBlock
+				GAPIKeyBlock.ToSharedRef()
 			]
 			+ SVerticalBox::Slot()
 			.HAlign(HAlign_Left)
@@ -381,7 +479,7 @@ void FWakaTimeForUEModule::OpenSettingsWindow()
 				.HAlign(HAlign_Center)
 				.VAlign(VAlign_Center)
 			[
-				GAPIUrlBlock
+				GAPIUrlBlock.ToSharedRef()
 			]
 		]
 		+ SVerticalBox::Slot()
@@ -402,19 +500,23 @@ void FWakaTimeForUEModule::OpenSettingsWindow()
 	if (MainFrameModule.GetParentWindow().IsValid())
 	{
 		FSlateApplication::Get().AddWindowAsNativeChild
-		(SettingsWindow, MainFrameModule.GetParentWindow()
+		(SettingsWindow.ToSharedRef(), MainFrameModule.GetParentWindow()
 		                                .ToSharedRef());
 	}
 	else
 	{
-		FSlateApplication::Get().AddWindow(SettingsWindow);
+		FSlateApplication::Get().AddWindow(SettingsWindow.ToSharedRef());
 	}
 }
 
 FReply FWakaTimeForUEModule::SaveData()
 {
-	GAPIKey = TCHAR_TO_UTF8(*(GAPIKeyBlock.Get().GetText().ToString()));
-	GAPIUrl = TCHAR_TO_UTF8(*(GAPIUrlBlock.Get().GetText().ToString()));
+	FWakaTimeConfig NewConfig;
+	NewConfig.ApiKey = TCHAR_TO_UTF8(*(GAPIKeyBlock->GetText().ToString()));
+	NewConfig.ApiUrl = TCHAR_TO_UTF8(*(GAPIUrlBlock->GetText().ToString()));
+	NewConfig.bFoundApiKey = !NewConfig.ApiKey.empty();
+	NewConfig.bFoundApiUrl = !NewConfig.ApiUrl.empty();
+	ApplyConfig(NewConfig);
 
 	string ConfigFileDir = string(GUserProfile) + "/.wakatime.cfg";
 	fstream ConfigFile(ConfigFileDir);
@@ -424,14 +526,14 @@ FReply FWakaTimeForUEModule::SaveData()
 		ConfigFile.open(ConfigFileDir, fstream::out);
 		// Pozitrone(Create the file if it does not exist) and write the data in it
 		ConfigFile << "[settings]" << '\n';
-		ConfigFile << "api_key = " << GAPIKey;
-		if(!GAPIUrl.empty())
+		ConfigFile << "api_key = " << Config.ApiKey << '\n';
+		if(!Config.ApiUrl.empty())
 		{
-			ConfigFile << "api_url = " << GAPIUrl;
+			ConfigFile << "api_url = " << Config.ApiUrl << '\n';
 		}
 		ConfigFile.close();
 
-		SettingsWindow.Get().RequestDestroyWindow();
+		CloseSettingsWindow();
 		return FReply::Handled();
 	}
 
@@ -452,8 +554,8 @@ FReply FWakaTimeForUEModule::SaveData()
 
 	bool bIsDirty = false;
 	
-	UpdateIniEntry(bIsDirty, Data, "api_key", GAPIKey);
-	UpdateIniEntry(bIsDirty, Data, "api_url", GAPIUrl);
+	UpdateIniEntry(bIsDirty, Data, "api_key", Config.ApiKey);
+	UpdateIniEntry(bIsDirty, Data, "api_url", Config.ApiUrl);
 	
 	if(bIsDirty)
 	{
@@ -471,10 +573,23 @@ FReply FWakaTimeForUEModule::SaveData()
 		ConfigFile.close();
 	}
 
-	SettingsWindow.Get().RequestDestroyWindow();
+	CloseSettingsWindow();
 	return FReply::Handled();
 }
 
+void FWakaTimeForUEModule::CloseSettingsWindow()
+{
+	if (SettingsWindow.IsValid())
+	{
+		SettingsWindow->RequestDestroyWindow();
+	}
+
+	// Slate keeps the window alive until it is destroyed; nothing here needs to outlive it
+	SettingsWindow.Reset();
+	GAPIKeyBlock.Reset();
+	GAPIUrlBlock.Reset();
+}
+
 void FWakaTimeForUEModule::UpdateIniEntry(bool& bIsDirty, map<string, string>& Data, string Key, string Value)
 {
 	if(Value.empty())
@@ -490,7 +605,7 @@ void FWakaTimeForUEModule::UpdateIniEntry(bool& bIsDirty, map<string, string>& D
 		{
 			Data.insert(std::make_pair(Key, Value));
 			bIsDirty =  true;
-		} else if(!Data[Key].compare(Value))
+		} else if(Data[Key] != Value)
 		{
 			Data[Key] = Value;
 			bIsDirty =  true;
@@ -499,115 +614,254 @@ void FWakaTimeForUEModule::UpdateIniEntry(bool& bIsDirty, map<string, string>& D
 }
 
 // Lifecycle methods
-void FWakaTimeForUEModule::SendHeartbeat(bool bFileSave, string Activity, string EntityType, FString Entity, string Language)
+void FWakaTimeForUEModule::SendHeartbeat(bool bFileSave, string Activity, string EntityType, FString Entity, string Language,
+                                         double Time)
 {
+	WAKATIME_FORUE_SCOPE(SendHeartbeat);
+
+	if (Time <= 0.0)
+	{
+		FDateTime Now = FDateTime::UtcNow();
+		Time = static_cast<double>(Now.ToUnixTimestamp()) + Now.GetMillisecond() / 1000.0;
+	}
+	if (!HeartbeatDedup.ShouldSend(Activity, Entity, bFileSave, Time))
+	{
+		return;
+	}
+
+	WAKATIME_FORUE_COUNT(HeartbeatsQueued, 1);
 	UE_LOG(LogWakaTime, Log, TEXT("Sending Heartbeat"));
+	string TimeStr = to_string(Time);
+	string ProjectName = GetProjectName();
+	FPaths::MakePlatformFilename(Entity);
+	string EntityStr = TCHAR_TO_UTF8(*Entity);
 
-	string Command = GBaseCommand;
+	FWakaTimeHeartbeat Heartbeat;
 
-	Command += " --config " + string(GUserProfile) + "\\.wakatime.cfg ";
-	Command += "--log-file " + string(GUserProfile) + "\\.wakatime\\wakatime.log ";
+	// Arguments, used when this heartbeat is the first of its batch
+	TArray<string>& Arguments = Heartbeat.Arguments;
+	Arguments.Append({"--config", GUserProfile + "/.wakatime.cfg"});
+	Arguments.Append({"--log-file", GUserProfile + "/.wakatime/wakatime.log"});
 
-	if(GAPIUrl != "")
+	if(Config.ApiUrl != "")
 	{
-		Command += "--api-url " + GAPIUrl + " ";
+		Arguments.Append({"--api-url", Config.ApiUrl});
 	}
 
-	Command += "--project \"" + GetProjectName() + "\" ";
-	Command += "--project-folder " + GProjectPath + " ";
-	string EntityStr = TCHAR_TO_UTF8(*Entity.Replace(TEXT("/"), TEXT("\\")));
-	Command += "--entity " + EntityStr + " ";
-	Command += "--entity-type \"" + EntityType + "\" ";
-	Command += "--language \"" + Language + "\" ";
-	Command += "--plugin \"unreal-wakatime/" + GPluginVersion + "\" ";
-	Command += "--category " + Activity + " ";
+	Arguments.Append({"--project", ProjectName});
+	Arguments.Append({"--project-folder", GProjectPath});
+	Arguments.Append({"--entity", EntityStr});
+	Arguments.Append({"--entity-type", EntityType});
+	Arguments.Append({"--language", Language});
+	Arguments.Append({"--plugin", "unreal-wakatime/" + GPluginVersion});
+	Arguments.Append({"--category", Activity});
+	Arguments.Append({"--time", TimeStr});
 
 	if (bFileSave)
 	{
-		Command += "--write";
+		Arguments.Add("--write");
 	}
 
-	bool bSuccess = false;
-	try
-	{
-		bSuccess = FWakaTimeHelpers::RunPowershellCommand(Command, false, INFINITE, true);
-	}
-	catch (int Err)
-	{
-		UE_LOG(LogWakaTime, Warning, TEXT("%i"), Err);
+	// JSON object, used when it rides along with another heartbeat through --extra-heartbeats
+	string& Json = Heartbeat.Json;
+	Json += "{\"entity\":";
+	FWakaTimeHelpers::AppendJsonString(Json, EntityStr);
+	Json += ",\"type\":";
+	FWakaTimeHelpers::AppendJsonString(Json, EntityType);
+	Json += ",\"category\":";
+	FWakaTimeHelpers::AppendJsonString(Json, Activity);
+	Json += ",\"language\":";
+	FWakaTimeHelpers::AppendJsonString(Json, Language);
+	Json += ",\"project\":";
+	FWakaTimeHelpers::AppendJsonString(Json, ProjectName);
+	Json += ",\"is_write\":";
+	Json += bFileSave ? "true" : "false";
+	Json += ",\"time\":" + TimeStr + "}";
+
+	size_t ByteCount = Json.size();
+	for (const string& Argument : Arguments)
+	{
+		ByteCount += Argument.size() + 1;
 	}
+	WAKATIME_FORUE_COUNT(PayloadBytes, ByteCount);
+
+	// Batched with its neighbours and sent on a worker thread; the result comes back in OnHeartbeatFinished
+	HeartbeatQueue.Enqueue(MoveTemp(Heartbeat));
+}
 
-	//bool success = RunCommand(command, false, baseCommand,INFINITE, true);
+void FWakaTimeForUEModule::OnHeartbeatFinished(bool bSuccess, uint32 ErrorCode, int32 NumHeartbeats)
+{
 	if (bSuccess)
 	{
-		UE_LOG(LogWakaTime, Log, TEXT("Heartbeat successfully sent."));
+		WAKATIME_FORUE_COUNT(HeartbeatsSent, NumHeartbeats);
+		UE_LOG(LogWakaTime, Log, TEXT("%d heartbeat(s) successfully sent."), NumHeartbeats);
 	}
 	else
 	{
-		UE_LOG(LogWakaTime, Error, TEXT("Heartbeat couldn't be sent."));
-		UE_LOG(LogWakaTime, Error, TEXT("Error code = %d"), GetLastError());
+		WAKATIME_FORUE_COUNT(HeartbeatsFailed, NumHeartbeats);
+		UE_LOG(LogWakaTime, Error, TEXT("%d heartbeat(s) couldn't be sent."), NumHeartbeats);
+		UE_LOG(LogWakaTime, Error, TEXT("Error code = %d"), ErrorCode);
 	}
 }
 
 // Event methods
 void FWakaTimeForUEModule::OnNewActorDropped(const TArray<UObject*>& Objects, const TArray<AActor*>& Actors)
 {
-	SendHeartbeat(false, "designing", "app", "Unreal Editor", "Unreal Editor");
+	WAKATIME_FORUE_SCOPE(OnNewActorDropped);
+	FWakaTimeFrameBudget::FScope BudgetScope(FrameBudget);
+	INC_DWORD_STAT(STAT_WakaTimeForUE_EventsNewActorDropped);
+
+	HeartbeatScheduler.Schedule(false, "designing", "app", TEXT("Unreal Editor"), "Unreal Editor");
 }
 
 void FWakaTimeForUEModule::OnDuplicateActorsEnd()
 {
-	SendHeartbeat(false, "designing", "app", "Unreal Editor", "Unreal Editor");
+	WAKATIME_FORUE_SCOPE(OnDuplicateActorsEnd);
+	FWakaTimeFrameBudget::FScope BudgetScope(FrameBudget);
+	INC_DWORD_STAT(STAT_WakaTimeForUE_EventsDuplicateActorsEnd);
+
+	HeartbeatScheduler.Schedule(false, "designing", "app", TEXT("Unreal Editor"), "Unreal Editor");
 }
 
 void FWakaTimeForUEModule::OnDeleteActorsEnd()
 {
-	SendHeartbeat(false, "designing", "app", "Unreal Editor", "Unreal Editor");
+	WAKATIME_FORUE_SCOPE(OnDeleteActorsEnd);
+	FWakaTimeFrameBudget::FScope BudgetScope(FrameBudget);
+	INC_DWORD_STAT(STAT_WakaTimeForUE_EventsDeleteActorsEnd);
+
+	HeartbeatScheduler.Schedule(false, "designing", "app", TEXT("Unreal Editor"), "Unreal Editor");
 }
 
 void FWakaTimeForUEModule::OnAddLevelToWorld(ULevel* Level)
 {
-	SendHeartbeat(false, "designing", "app", "Unreal Editor", "Unreal Editor");
+	WAKATIME_FORUE_SCOPE(OnAddLevelToWorld);
+	FWakaTimeFrameBudget::FScope BudgetScope(FrameBudget);
+	INC_DWORD_STAT(STAT_WakaTimeForUE_EventsAddLevelToWorld);
+
+	HeartbeatScheduler.Schedule(false, "designing", "app", TEXT("Unreal Editor"), "Unreal Editor");
 }
 
 #if ENGINE_MAJOR_VERSION == 5
 	void FWakaTimeForUEModule::OnPostSaveWorld(UWorld* World, FObjectPostSaveContext Context)
 	{
-		SendHeartbeat(true, "designing", "app", "Unreal Editor", "Unreal Editor");
+		WAKATIME_FORUE_SCOPE(OnPostSaveWorld);
+		FWakaTimeFrameBudget::FScope BudgetScope(FrameBudget);
+		INC_DWORD_STAT(STAT_WakaTimeForUE_EventsPostSaveWorld);
+
+		HeartbeatScheduler.Schedule(true, "designing", "app", TEXT("Unreal Editor"), "Unreal Editor");
 }
 #else
 	void FWakaTimeForUEModule::OnPostSaveWorld(uint32 SaveFlags, UWorld* World, bool bSucces)
 	{
-		SendHeartbeat(true, "designing", "app", "Unreal Editor", "Unreal Editor");
+		WAKATIME_FORUE_SCOPE(OnPostSaveWorld);
+		FWakaTimeFrameBudget::FScope BudgetScope(FrameBudget);
+		INC_DWORD_STAT(STAT_WakaTimeForUE_EventsPostSaveWorld);
+
+		HeartbeatScheduler.Schedule(true, "designing", "app", TEXT("Unreal Editor"), "Unreal Editor");
 	}
 #endif
 
 void FWakaTimeForUEModule::OnPostPieStarted(bool bIsSimulating)
 {
+	WAKATIME_FORUE_SCOPE(OnPostPieStarted);
+	FWakaTimeFrameBudget::FScope BudgetScope(FrameBudget);
+	INC_DWORD_STAT(STAT_WakaTimeForUE_EventsPostPieStarted);
+
+	SendHeartbeat(false, "debugging", "app", "Unreal Editor", "Unreal Editor");
+
+	// Nothing the editor hooks would see during PIE is editing; drop them for the session and let a
+	// slow ticker report the debugging time instead, so the PIE frame loop never calls into the plugin
+	if (PieTickerHandle.IsValid())
+	{
+		return;
+	}
+	UnbindEditorEvents();
+
+	float Interval = FMath::Max(CVarWakaTimePieHeartbeatInterval.GetValueOnGameThread(), 10.0f);
+#if ENGINE_MAJOR_VERSION >= 5
+	PieTickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateRaw(this, &FWakaTimeForUEModule::OnPieTick), Interval);
+#else
+	PieTickerHandle = FTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateRaw(this, &FWakaTimeForUEModule::OnPieTick), Interval);
+#endif
+}
+
+bool FWakaTimeForUEModule::OnPieTick(float DeltaTime)
+{
+	WAKATIME_FORUE_SCOPE(OnPieTick);
+	FWakaTimeFrameBudget::FScope BudgetScope(FrameBudget);
+
 	SendHeartbeat(false, "debugging", "app", "Unreal Editor", "Unreal Editor");
+	return true;
 }
 
 void FWakaTimeForUEModule::OnPrePieEnded(bool bIsSimulating)
 {
+	WAKATIME_FORUE_SCOPE(OnPrePieEnded);
+	FWakaTimeFrameBudget::FScope BudgetScope(FrameBudget);
+	INC_DWORD_STAT(STAT_WakaTimeForUE_EventsPrePieEnded);
+
+	if (PieTickerHandle.IsValid())
+	{
+#if ENGINE_MAJOR_VERSION >= 5
+		FTSTicker::GetCoreTicker().RemoveTicker(PieTickerHandle);
+#else
+		FTicker::GetCoreTicker().RemoveTicker(PieTickerHandle);
+#endif
+		PieTickerHandle.Reset();
+		BindEditorEvents();
+	}
+
 	SendHeartbeat(true, "debugging", "app", "Unreal Editor", "Unreal Editor");
 }
 
 void FWakaTimeForUEModule::OnBlueprintPreCompile(UBlueprint* Blueprint)
 {
+	WAKATIME_FORUE_SCOPE(OnBlueprintPreCompile);
+	FWakaTimeFrameBudget::FScope BudgetScope(FrameBudget);
+	INC_DWORD_STAT(STAT_WakaTimeForUE_EventsBlueprintPreCompile);
+
 #if ENGINE_MAJOR_VERSION >= 5 && ENGINE_MINOR_VERSION >= 4 // RedTheKitsune(OnAssetClosedInEditor is not available in <UE5.4, so blueprint name tracking will not work properly)
-	auto Found = OpenedBPs.ContainsByPredicate([Blueprint](const TSharedRef<FString>& BPName)
-		{
-			return *BPName == Blueprint->GetName();
-		});
-	
-	if(!Found) return;
+	// Compiling one blueprint recompiles its children too; only the ones the user has open count.
+	// This is a set add, so it stays in even over the frame budget
+	FName PackageName = Blueprint->GetOutermost()->GetFName();
+	if (OpenedBPs.Contains(PackageName))
+	{
+		CompiledBPs.Add(PackageName);
+	}
+#else
+	bBlueprintCompiled = true;
+#endif
+}
+
+void FWakaTimeForUEModule::OnBlueprintCompiled()
+{
+	WAKATIME_FORUE_SCOPE(OnBlueprintCompiled);
+	FWakaTimeFrameBudget::FScope BudgetScope(FrameBudget);
 
-	FString PackageName = Blueprint->GetOutermost()->GetName();
-	FString FilePath = FPackageName::LongPackageNameToFilename(PackageName, FPackageName::GetAssetPackageExtension());
- 
-	SendHeartbeat(true, "coding", "file", TCHAR_TO_UTF8(*FilePath), "Blueprints");
+#if ENGINE_MAJOR_VERSION >= 5 && ENGINE_MINOR_VERSION >= 4 // RedTheKitsune(OnAssetClosedInEditor is not available in <UE5.4, so blueprint name tracking will not work properly)
+	if (FrameBudget.IsDegraded() && CompiledBPs.Num() > 1)
+	{
+		// Skip the per-blueprint file paths; the time is still credited to Blueprints
+		CompiledBPs.Reset();
+		SendHeartbeat(true, "coding", "app", "Unreal Editor", "Blueprints");
+		return;
+	}
+
+	for (const FName& PackageName : CompiledBPs)
+	{
+		FString FilePath = FPackageName::LongPackageNameToFilename(PackageName.ToString(),
+		                                                           FPackageName::GetAssetPackageExtension());
+		SendHeartbeat(true, "coding", "file", FilePath, "Blueprints");
+	}
+	CompiledBPs.Reset();
 #else
-	SendHeartbeat(true, "coding", "app", "Unreal Editor", "Blueprints");
+	if (bBlueprintCompiled)
+	{
+		bBlueprintCompiled = false;
+		SendHeartbeat(true, "coding", "app", "Unreal Editor", "Blueprints");
+	}
 #endif
 }
 
@@ -616,17 +870,14 @@ void FWakaTimeForUEModule::OnAssetOpened(UObject* Asset, IAssetEditorInstance* A
 {
 	if(!Asset->IsA<UBlueprint>()) return;
 	
-	OpenedBPs.Add(MakeShared<FString>(Asset->GetName()));
+	OpenedBPs.Add(Asset->GetOutermost()->GetFName());
 }
 
 void FWakaTimeForUEModule::OnAssetClosed(UObject* Asset, IAssetEditorInstance* AssetEditor)
 {
 	if(!Asset->IsA<UBlueprint>()) return;
 	
-	OpenedBPs.RemoveAll([Asset](const TSharedRef<FString>& BPName)
-	{
-		return *BPName == Asset->GetName();
-	});
+	OpenedBPs.Remove(Asset->GetOutermost()->GetFName());
 }
 #endif
 
@@ -643,6 +894,7 @@ void FWakaTimeForUEModule::OnEditorInitialized(double TimeToInitializeEditor)
 #endif
 		
 		OnBlueprintPreCompileHandle = GEditor->OnBlueprintPreCompile().AddRaw(this, &FWakaTimeForUEModule::OnBlueprintPreCompile);
+		OnBlueprintCompiledHandle = GEditor->OnBlueprintCompiled().AddRaw(this, &FWakaTimeForUEModule::OnBlueprintCompiled);
 	}
 	else
 	{
@@ -655,5 +907,3 @@ void FWakaTimeForUEModule::OnEditorInitialized(double TimeToInitializeEditor)
 #undef LOCTEXT_NAMESPACE
 
 IMPLEMENT_MODULE(FWakaTimeForUEModule, WakaTimeForUE)
-
-#include "Windows/HideWindowsPlatformTypes.h"
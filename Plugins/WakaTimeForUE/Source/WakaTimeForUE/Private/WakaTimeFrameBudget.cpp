@@ -0,0 +1,111 @@
+#include "WakaTimeFrameBudget.h"
+
+#include "CoreGlobals.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "WakaTimeForUE.h"
+#include "WakaTimeStats.h"
+
+static TAutoConsoleVariable<float> CVarWakaTimeFrameBudget(
+	TEXT("WakaTime.FrameBudget"),
+	50.0f,
+	TEXT("Microseconds of game-thread time per frame the plugin may spend in its editor callbacks before it sends ")
+	TEXT("one heartbeat per blueprint compile batch and merges heartbeats over a longer window. 0 turns the guard off."));
+
+static TAutoConsoleVariable<int32> CVarWakaTimeFrameBudgetRecoveryFrames(
+	TEXT("WakaTime.FrameBudgetRecoveryFrames"),
+	300,
+	TEXT("Frames in a row under half the frame budget before full fidelity comes back."));
+
+FWakaTimeFrameBudget::FScope::FScope(FWakaTimeFrameBudget& InBudget)
+	: Budget(InBudget)
+{
+	if (!Budget.bEnabled || !IsInGameThread())
+	{
+		return;
+	}
+
+	bCounted = true;
+	if (Budget.Depth++ == 0)
+	{
+		Budget.AdvanceFrame();
+		if (Budget.BudgetCycles > 0)
+		{
+			StartCycles = FPlatformTime::Cycles64();
+		}
+	}
+}
+
+FWakaTimeFrameBudget::FScope::~FScope()
+{
+	if (!bCounted || --Budget.Depth > 0 || StartCycles == 0)
+	{
+		return;
+	}
+
+	Budget.FrameCycles += FPlatformTime::Cycles64() - StartCycles;
+	if (!Budget.bDegraded && Budget.FrameCycles > Budget.BudgetCycles)
+	{
+		// Compile All runs every blueprint's callbacks inside one frame, so degrading has to start mid-frame
+		Budget.SetDegraded(true);
+	}
+}
+
+void FWakaTimeFrameBudget::Initialize(FOnDegradedChanged InOnDegradedChanged)
+{
+	OnDegradedChanged = MoveTemp(InOnDegradedChanged);
+	bEnabled = !IsRunningCommandlet();
+}
+
+void FWakaTimeFrameBudget::AdvanceFrame()
+{
+	uint64 Now = GFrameCounter;
+	if (Now == Frame)
+	{
+		return;
+	}
+
+	// GFrameCounter can jump by more than one when nothing called us for a while; those frames cost nothing
+	if (FrameCycles > BudgetCycles)
+	{
+		INC_DWORD_STAT(STAT_WakaTimeForUE_BudgetOverruns);
+		QuietFrames = 0;
+	}
+	else if (FrameCycles * 2 > BudgetCycles)
+	{
+		QuietFrames = 0;
+	}
+	else
+	{
+		QuietFrames++;
+	}
+	QuietFrames += Now - Frame - 1;
+
+	Frame = Now;
+	FrameCycles = 0;
+
+	double BudgetSeconds = CVarWakaTimeFrameBudget.GetValueOnGameThread() / 1000000.0;
+	BudgetCycles = BudgetSeconds > 0.0
+		               ? FMath::Max<uint64>(static_cast<uint64>(BudgetSeconds / FPlatformTime::GetSecondsPerCycle64()), 1)
+		               : 0;
+
+	uint64 RecoveryFrames = static_cast<uint64>(FMath::Max(CVarWakaTimeFrameBudgetRecoveryFrames.GetValueOnGameThread(), 1));
+	if (bDegraded && (BudgetCycles == 0 || QuietFrames >= RecoveryFrames))
+	{
+		SetDegraded(false);
+	}
+}
+
+void FWakaTimeFrameBudget::SetDegraded(bool bInDegraded)
+{
+	bDegraded = bInDegraded;
+	QuietFrames = 0;
+	UE_LOG(LogWakaTime, Verbose, TEXT("%s"), bDegraded
+		       ? TEXT("Over the frame budget, merging heartbeats")
+		       : TEXT("Back under the frame budget, sending every heartbeat"));
+
+	if (OnDegradedChanged)
+	{
+		OnDegradedChanged(bDegraded);
+	}
+}
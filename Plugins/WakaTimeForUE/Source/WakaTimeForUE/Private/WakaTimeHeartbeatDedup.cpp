@@ -0,0 +1,39 @@
+#include "WakaTimeHeartbeatDedup.h"
+
+#include "WakaTimeStats.h"
+
+// A repeat of the same entity inside this many seconds is thrown away by the API, so there's no point sending it
+static const double DedupWindowSeconds = 120.0;
+
+FWakaTimeHeartbeatDedup::FWakaTimeHeartbeatDedup(int32 InMaxEntries)
+	: Sent(InMaxEntries)
+{
+}
+
+bool FWakaTimeHeartbeatDedup::ShouldSend(const std::string& Activity, const FString& Entity, bool bIsWrite, double Time)
+{
+	Lookups++;
+	FString Key = FString(UTF8_TO_TCHAR(Activity.c_str())) + TEXT("|") + Entity;
+	FSent* Previous = Sent.FindAndTouch(Key);
+
+	// Debounced heartbeats carry the time of their last event, so they can be older than the last one sent
+	if (Previous && Previous->bIsWrite == bIsWrite && FMath::Abs(Time - Previous->Time) < DedupWindowSeconds)
+	{
+		Hits++;
+		INC_DWORD_STAT(STAT_WakaTimeForUE_HeartbeatsDeduplicated);
+		SET_FLOAT_STAT(STAT_WakaTimeForUE_DedupHitRate, GetHitRate() * 100.0);
+		return false;
+	}
+
+	if (Previous)
+	{
+		Previous->Time = Time;
+		Previous->bIsWrite = bIsWrite;
+	}
+	else
+	{
+		Sent.Add(Key, FSent{Time, bIsWrite});
+	}
+	SET_FLOAT_STAT(STAT_WakaTimeForUE_DedupHitRate, GetHitRate() * 100.0);
+	return true;
+}
@@ -0,0 +1,264 @@
+#include "WakaTimeHeartbeatQueue.h"
+
+#include "HAL/RunnableThread.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/ScopeLock.h"
+#include "Async/Async.h"
+#include "WakaTimeForUE.h"
+#include "WakaTimeHelpers.h"
+#include "WakaTimeHttpTransport.h"
+#include "WakaTimeStats.h"
+
+// A batch that takes longer than this is abandoned, so a hung CLI can't hold a worker forever
+static const int HeartbeatTimeoutMs = 30000;
+
+// Heartbeats still queued at shutdown get this long in total, so closing the editor is never held up for long
+static const int ShutdownFlushTimeoutMs = 3000;
+
+// How long the first heartbeat of a batch waits for others to join it
+static const double BatchWindowSeconds = 2.0;
+
+// The CLI sends at most this many heartbeats per API request; larger batches go out as several processes.
+// Without stdin for the child every heartbeat needs its own process
+static const int32 MaxBatchSize = FWakaTimeHelpers::SupportsProcessInput() ? 25 : 1;
+
+void FWakaTimeHeartbeatQueue::Start(std::string InCliPath, int32 InMaxConcurrency, int32 InCapacity,
+                                    FOnHeartbeatFinished InOnFinished, FWakaTimeHttpTransport* InTransport)
+{
+	CliPath = MoveTemp(InCliPath);
+	Transport = InTransport;
+	Capacity = FMath::Max(InCapacity, 1);
+	OnFinished = MoveTemp(InOnFinished);
+	AliveToken = MakeShared<bool, ESPMode::ThreadSafe>(true);
+	WeakAliveToken = AliveToken;
+	bStopping = false;
+	WorkAvailable = FPlatformProcess::GetSynchEventFromPool(false);
+
+	for (int32 Index = 0; Index < FMath::Max(InMaxConcurrency, 1); Index++)
+	{
+		FString ThreadName = FString::Printf(TEXT("WakaTimeHeartbeat%d"), Index);
+		if (FRunnableThread* Thread = FRunnableThread::Create(this, *ThreadName, 0, TPri_BelowNormal))
+		{
+			Threads.Add(Thread);
+		}
+	}
+}
+
+void FWakaTimeHeartbeatQueue::Shutdown()
+{
+	AliveToken.Reset();
+	Stop();
+
+	for (FRunnableThread* Thread : Threads)
+	{
+		Thread->WaitForCompletion();
+		delete Thread;
+	}
+	Threads.Empty();
+
+	if (WorkAvailable)
+	{
+		FPlatformProcess::ReturnSynchEventToPool(WorkAvailable);
+		WorkAvailable = nullptr;
+	}
+
+	// The workers are gone, so what is left (including batches they gave back when cancelled) is ours alone
+	TArray<FWakaTimeHeartbeat> Remaining = MoveTemp(Jobs);
+	double Deadline = FPlatformTime::Seconds() + ShutdownFlushTimeoutMs / 1000.0;
+	while (Remaining.Num() > 0)
+	{
+		int RemainingMs = static_cast<int>((Deadline - FPlatformTime::Seconds()) * 1000.0);
+		if (RemainingMs <= 0)
+		{
+			UE_LOG(LogWakaTime, Warning, TEXT("Shutting down with %d heartbeats unsent"), Remaining.Num());
+			WAKATIME_FORUE_COUNT(HeartbeatsFailed, Remaining.Num());
+			break;
+		}
+
+		int32 Count = FMath::Min(Remaining.Num(), MaxBatchSize);
+		TArray<FWakaTimeHeartbeat> Batch;
+		for (int32 Index = 0; Index < Count; Index++)
+		{
+			Batch.Add(MoveTemp(Remaining[Index]));
+		}
+		Remaining.RemoveAt(0, Count);
+
+		if (!RunBatch(Batch, RemainingMs, nullptr))
+		{
+			WAKATIME_FORUE_COUNT(HeartbeatsFailed, Batch.Num());
+		}
+	}
+}
+
+void FWakaTimeHeartbeatQueue::Enqueue(FWakaTimeHeartbeat Heartbeat)
+{
+	bool bBatchFull;
+	{
+		FScopeLock ScopeLock(&Lock);
+		if (Jobs.Num() >= Capacity)
+		{
+			// Newer heartbeats describe the current activity better than old ones
+			Jobs.RemoveAt(0);
+			WAKATIME_FORUE_COUNT(HeartbeatsFailed, 1);
+			UE_LOG(LogWakaTime, Warning, TEXT("Heartbeat queue full, dropping the oldest heartbeat"));
+		}
+
+		Heartbeat.QueuedTime = FPlatformTime::Seconds();
+		Jobs.Add(MoveTemp(Heartbeat));
+		bBatchFull = Jobs.Num() >= MaxBatchSize;
+	}
+
+	// Workers poll for the batch window on their own; only wake one early when there's a full batch
+	if (bBatchFull && WorkAvailable)
+	{
+		WorkAvailable->Trigger();
+	}
+}
+
+void FWakaTimeHeartbeatQueue::Pause()
+{
+	bPaused = true;
+}
+
+void FWakaTimeHeartbeatQueue::Resume()
+{
+	bPaused = false;
+	if (WorkAvailable)
+	{
+		WorkAvailable->Trigger();
+	}
+}
+
+bool FWakaTimeHeartbeatQueue::DequeueBatch(TArray<FWakaTimeHeartbeat>& OutBatch, uint32& OutWaitMs)
+{
+	FScopeLock ScopeLock(&Lock);
+	if (Jobs.Num() == 0 || bPaused)
+	{
+		OutWaitMs = 100;
+		return false;
+	}
+
+	double Age = FPlatformTime::Seconds() - Jobs[0].QueuedTime;
+	if (Jobs.Num() < MaxBatchSize && Age < BatchWindowSeconds && !bStopping)
+	{
+		OutWaitMs = FMath::Clamp(static_cast<uint32>((BatchWindowSeconds - Age) * 1000.0), 1u, 100u);
+		return false;
+	}
+
+	int32 Count = FMath::Min(Jobs.Num(), MaxBatchSize);
+	OutBatch.Reset(Count);
+	for (int32 Index = 0; Index < Count; Index++)
+	{
+		OutBatch.Add(MoveTemp(Jobs[Index]));
+	}
+	Jobs.RemoveAt(0, Count);
+	return true;
+}
+
+bool FWakaTimeHeartbeatQueue::RunBatch(const TArray<FWakaTimeHeartbeat>& Batch, int WaitMs,
+                                       const FThreadSafeBool* Cancel)
+{
+	// The first heartbeat goes on the command line, the rest as a JSON array on stdin
+	TArray<std::string> Arguments = Batch[0].Arguments;
+	std::string Input;
+	if (Batch.Num() > 1)
+	{
+		Arguments.Add("--extra-heartbeats");
+		Input += "[";
+		for (int32 Index = 1; Index < Batch.Num(); Index++)
+		{
+			if (Index > 1)
+			{
+				Input += ",";
+			}
+			Input += Batch[Index].Json;
+		}
+		Input += "]\n";
+	}
+
+	return FWakaTimeHelpers::RunProcess(CliPath, Arguments, Input, WaitMs, Cancel);
+}
+
+uint32 FWakaTimeHeartbeatQueue::Run()
+{
+	TArray<FWakaTimeHeartbeat> Batch;
+	while (!bStopping)
+	{
+		uint32 WaitMs = 100;
+		if (!DequeueBatch(Batch, WaitMs))
+		{
+			// Auto-reset event; the timeout covers both the batch window and a trigger that woke a different worker
+			WorkAvailable->Wait(WaitMs);
+			continue;
+		}
+
+		bool bSuccess = false;
+		double QueuedTime = Batch[0].QueuedTime;
+		if (Transport && Transport->IsEnabled())
+		{
+			TArray<int32> Failed;
+			bSuccess = Transport->Send(Batch, bStopping, Failed);
+			if (bSuccess && Failed.Num() > 0)
+			{
+				// Only the rejected heartbeats go on to the CLI; resending the rest would duplicate them
+				ReportFinished(true, 0, Batch.Num() - Failed.Num());
+				TArray<FWakaTimeHeartbeat> Rejected;
+				Rejected.Reserve(Failed.Num());
+				for (int32 Index : Failed)
+				{
+					Rejected.Add(MoveTemp(Batch[Index]));
+				}
+				Batch = MoveTemp(Rejected);
+				bSuccess = false;
+			}
+			if (!bSuccess && !bStopping)
+			{
+				INC_DWORD_STAT_BY(STAT_WakaTimeForUE_HttpFallbacks, Batch.Num());
+				UE_LOG(LogWakaTime, Log, TEXT("Native HTTP send failed for %d heartbeat(s), handing them to wakatime-cli"),
+				       Batch.Num());
+			}
+		}
+
+		if (!bSuccess && !bStopping)
+		{
+			bSuccess = RunBatch(Batch, HeartbeatTimeoutMs, &bStopping);
+		}
+
+		if (!bSuccess && bStopping)
+		{
+			// Cut short by shutdown; hand the batch back so Shutdown sends it with the rest
+			FScopeLock ScopeLock(&Lock);
+			Jobs.Insert(MoveTemp(Batch), 0);
+			break;
+		}
+		uint32 ErrorCode = bSuccess ? 0 : FPlatformMisc::GetLastError();
+		WakaTimeStats::RecordRequestLatency(FPlatformTime::Seconds() - QueuedTime);
+		ReportFinished(bSuccess, ErrorCode, Batch.Num());
+	}
+	return 0;
+}
+
+void FWakaTimeHeartbeatQueue::ReportFinished(bool bSuccess, uint32 ErrorCode, int32 NumHeartbeats)
+{
+	TWeakPtr<bool, ESPMode::ThreadSafe> WeakAlive = WeakAliveToken;
+	AsyncTask(ENamedThreads::GameThread, [this, WeakAlive, bSuccess, ErrorCode, NumHeartbeats]()
+	{
+		if (WeakAlive.IsValid() && OnFinished)
+		{
+			OnFinished(bSuccess, ErrorCode, NumHeartbeats);
+		}
+	});
+}
+
+void FWakaTimeHeartbeatQueue::Stop()
+{
+	bStopping = true;
+	if (WorkAvailable)
+	{
+		for (int32 Index = 0; Index < Threads.Num(); Index++)
+		{
+			WorkAvailable->Trigger();
+		}
+	}
+}
@@ -0,0 +1,154 @@
+#include "WakaTimeHeartbeatScheduler.h"
+
+#include "HAL/IConsoleManager.h"
+#include "Misc/DateTime.h"
+#include "WakaTimeStats.h"
+
+static TAutoConsoleVariable<float> CVarWakaTimeDebounceWindow(
+	TEXT("WakaTime.DebounceWindow"),
+	10.0f,
+	TEXT("Seconds over which editor events for the same category and entity are merged into one heartbeat. ")
+	TEXT("0 sends every event right away."));
+
+// Wheel granularity and size; deadlines further out than one revolution just go around again
+static const double WheelResolution = 0.25;
+static const int32 WheelSlots = 64;
+
+static double GetUnixTime()
+{
+	FDateTime Now = FDateTime::UtcNow();
+	return static_cast<double>(Now.ToUnixTimestamp()) + Now.GetMillisecond() / 1000.0;
+}
+
+void FWakaTimeHeartbeatScheduler::Initialize(FSendHeartbeat InSend)
+{
+	SendHeartbeat = MoveTemp(InSend);
+	Wheel.SetNum(WheelSlots);
+}
+
+void FWakaTimeHeartbeatScheduler::Shutdown()
+{
+	if (TickerHandle.IsValid())
+	{
+#if ENGINE_MAJOR_VERSION >= 5
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+#else
+		FTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+#endif
+		TickerHandle.Reset();
+	}
+
+	for (const TPair<FString, FPendingHeartbeat>& Entry : Pending)
+	{
+		Send(Entry.Value);
+	}
+	Pending.Empty();
+	for (TArray<FString>& Slot : Wheel)
+	{
+		Slot.Reset();
+	}
+}
+
+void FWakaTimeHeartbeatScheduler::Schedule(bool bIsWrite, const std::string& Activity, const std::string& EntityType,
+                                           const FString& Entity, const std::string& Language)
+{
+	double Window = CVarWakaTimeDebounceWindow.GetValueOnGameThread() * WindowScale;
+	if (Window <= 0.0)
+	{
+		if (SendHeartbeat)
+		{
+			SendHeartbeat(bIsWrite, Activity, EntityType, Entity, Language, GetUnixTime());
+		}
+		return;
+	}
+
+	FString Key = FString(UTF8_TO_TCHAR(Activity.c_str())) + TEXT("|") + Entity;
+	if (FPendingHeartbeat* Existing = Pending.Find(Key))
+	{
+		Existing->bIsWrite |= bIsWrite;
+		Existing->Time = GetUnixTime();
+		INC_DWORD_STAT(STAT_WakaTimeForUE_HeartbeatsDebounced);
+		return;
+	}
+
+	double Now = FPlatformTime::Seconds();
+	if (!TickerHandle.IsValid())
+	{
+		CurrentTick = static_cast<int64>(Now / WheelResolution);
+#if ENGINE_MAJOR_VERSION >= 5
+		TickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+			FTickerDelegate::CreateRaw(this, &FWakaTimeHeartbeatScheduler::Tick), WheelResolution);
+#else
+		TickerHandle = FTicker::GetCoreTicker().AddTicker(
+			FTickerDelegate::CreateRaw(this, &FWakaTimeHeartbeatScheduler::Tick), WheelResolution);
+#endif
+	}
+
+	FPendingHeartbeat& Added = Pending.Add(Key);
+	Added.bIsWrite = bIsWrite;
+	Added.Activity = Activity;
+	Added.EntityType = EntityType;
+	Added.Entity = Entity;
+	Added.Language = Language;
+	Added.Time = GetUnixTime();
+	Added.DueTime = Now + Window;
+	AddToWheel(Key, Added.DueTime);
+}
+
+bool FWakaTimeHeartbeatScheduler::Tick(float DeltaTime)
+{
+	WAKATIME_FORUE_SCOPE(SchedulerTick);
+
+	double Now = FPlatformTime::Seconds();
+	int64 NowTick = static_cast<int64>(Now / WheelResolution);
+
+	// After a long hitch every slot is visited once, which is enough since each key sits in exactly one slot
+	int64 FirstTick = FMath::Max(CurrentTick + 1, NowTick - WheelSlots + 1);
+	CurrentTick = NowTick;
+
+	for (int64 WheelTick = FirstTick; WheelTick <= NowTick; WheelTick++)
+	{
+		TArray<FString> Keys = MoveTemp(Wheel[WheelTick % WheelSlots]);
+		Wheel[WheelTick % WheelSlots].Reset();
+
+		for (const FString& Key : Keys)
+		{
+			FPendingHeartbeat* Entry = Pending.Find(Key);
+			if (!Entry)
+			{
+				continue;
+			}
+
+			if (Entry->DueTime <= Now)
+			{
+				Send(*Entry);
+				Pending.Remove(Key);
+			}
+			else
+			{
+				AddToWheel(Key, Entry->DueTime);
+			}
+		}
+	}
+
+	if (Pending.Num() == 0)
+	{
+		TickerHandle.Reset();
+		return false;
+	}
+	return true;
+}
+
+void FWakaTimeHeartbeatScheduler::AddToWheel(const FString& Key, double DueTime)
+{
+	int64 DueTick = FMath::Max(static_cast<int64>(DueTime / WheelResolution), CurrentTick + 1);
+	Wheel[DueTick % WheelSlots].Add(Key);
+}
+
+void FWakaTimeHeartbeatScheduler::Send(const FPendingHeartbeat& Entry) const
+{
+	if (SendHeartbeat)
+	{
+		SendHeartbeat(Entry.bIsWrite, Entry.Activity, Entry.EntityType, Entry.Entity, Entry.Language, Entry.Time);
+	}
+}
@@ -1,107 +1,244 @@
-﻿#include "WakaTimeHelpers.h"
+#include "WakaTimeHelpers.h"
 
-#include <activation.h>
 #include <string>
 
+#include "HAL/PlatformProcess.h"
+#include "Misc/Paths.h"
 #include "WakaTimeForUE.h"
 
+#if PLATFORM_WINDOWS
+static const char* PowershellExe = "C:\\Windows\\System32\\WindowsPowerShell\\v1.0\\powershell.exe";
+#else
+static const char* UnzipExe = "/usr/bin/unzip";
+#endif
+
+// Standard input goes to the child this much at a time, from inside the wait loop
+static const size_t InputChunkBytes = 4096;
+
 bool FWakaTimeHelpers::PathExists(const std::string& Path)
 {
-	struct stat Buffer;
-	return (stat(Path.c_str(), &Buffer) == 0);
+	FString PathString = UTF8_TO_TCHAR(Path.c_str());
+	return FPaths::FileExists(PathString) || FPaths::DirectoryExists(PathString);
 }
 
 
-bool FWakaTimeHelpers::RunCommand(std::string CommandToRun, bool bRequireNonZeroProcess,
-                                  std::string ExeToRun, int WaitMs, bool bRunPure,
-                                  std::string Directory)
+bool FWakaTimeHelpers::RunProcess(const std::string& ExeToRun, const TArray<std::string>& Arguments,
+                                  const std::string& Input, int WaitMs, const FThreadSafeBool* Cancel)
 {
-	if (bRunPure)
-	{
-		CommandToRun = " " + CommandToRun;
-	}
-	else
+	std::string Params;
+	for (const std::string& Argument : Arguments)
 	{
-		CommandToRun = " /c start /b " + CommandToRun;
+		if (!Params.empty())
+		{
+			Params += ' ';
+		}
+		Params += QuoteArgument(Argument);
 	}
 
-	UE_LOG(LogWakaTime, Log, TEXT("Running command: %s"), *FString(UTF8_TO_TCHAR(CommandToRun.c_str())));
+	FString ExePath = UTF8_TO_TCHAR(ExeToRun.c_str());
+	FString ParamsString = UTF8_TO_TCHAR(Params.c_str());
+	UE_LOG(LogWakaTime, Log, TEXT("Running %s %s"), *ExePath, *ParamsString);
 
-	STARTUPINFO Startupinfo;
-	PROCESS_INFORMATION Process_Information;
+	// The child gets the read end of the pipe as its stdin; the write end stays with us, so closing it is the
+	// child's end-of-file
+	void* StdInRead = nullptr;
+	void* StdInWrite = nullptr;
+	if (!Input.empty())
+	{
+		if (!SupportsProcessInput())
+		{
+			UE_LOG(LogWakaTime, Warning, TEXT("Standard input for child processes needs Unreal Engine 5"));
+			return false;
+		}
+#if ENGINE_MAJOR_VERSION >= 5
+		if (!FPlatformProcess::CreatePipe(StdInRead, StdInWrite, true))
+		{
+			return false;
+		}
+#endif
+	}
 
-	ZeroMemory(&Startupinfo, sizeof(Startupinfo));
-	Startupinfo.cb = sizeof(Startupinfo);
-	ZeroMemory(&Process_Information, sizeof(Process_Information));
+	FProcHandle Process = FPlatformProcess::CreateProc(*ExePath, *ParamsString,
+	                                                   false, // not detached, we wait for it
+	                                                   true, // hidden
+	                                                   true, // really hidden, no console window
+	                                                   nullptr,
+	                                                   0,
+	                                                   nullptr,
+	                                                   nullptr,
+	                                                   StdInRead);
+
+	// The child has its own copy of the read end now
+	if (StdInRead)
+	{
+		FPlatformProcess::ClosePipe(StdInRead, nullptr);
+	}
 
-	bool bSuccess = CreateProcess(*FString(UTF8_TO_TCHAR(ExeToRun.c_str())), // use cmd or powershell
-	                              UTF8_TO_TCHAR(CommandToRun.c_str()), // the command
-	                              nullptr, // Process handle not inheritable
-	                              nullptr, // Thread handle not inheritable
-	                              false, // Set handle inheritance to FALSE
-	                              CREATE_NO_WINDOW, // Don't open the console window
-	                              nullptr, // Use parent's environment block
-	                              Directory == "" ? nullptr : *FString(UTF8_TO_TCHAR(Directory.c_str())),
-	                              // Use parent's starting directory 
-	                              &Startupinfo, // Pointer to STARTUPINFO structure
-	                              &Process_Information); // Pointer to PROCESS_INFORMATION structure
+	if (!Process.IsValid())
+	{
+		if (StdInWrite)
+		{
+			FPlatformProcess::ClosePipe(nullptr, StdInWrite);
+		}
+		return false;
+	}
 
-	// Close process and thread handles.
-	bool bReturnValue;
+	// Input is written a chunk per pass of the wait loop, so a child that stops reading runs into the deadline or
+	// the cancel flag instead of leaving this thread stuck on a full pipe
+	size_t InputWritten = 0;
+	bool bInputFailed = false;
+	double Deadline = WaitMs < 0 ? TNumericLimits<double>::Max() : FPlatformTime::Seconds() + WaitMs / 1000.0;
+	while (FPlatformProcess::IsProcRunning(Process))
+	{
+		bool bPipeTookChunk = false;
+#if ENGINE_MAJOR_VERSION >= 5
+		if (StdInWrite)
+		{
+			int32 ChunkBytes = static_cast<int32>(FMath::Min(Input.size() - InputWritten, InputChunkBytes));
+			int32 BytesWritten = 0;
+			if (!FPlatformProcess::WritePipe(StdInWrite, reinterpret_cast<const uint8*>(Input.data()) + InputWritten,
+			                                 ChunkBytes, &BytesWritten))
+			{
+				UE_LOG(LogWakaTime, Warning, TEXT("Could not write the input of %s, terminating it"), *ExePath);
+				FPlatformProcess::TerminateProc(Process, true);
+				bInputFailed = true;
+				break;
+			}
+			InputWritten += static_cast<size_t>(FMath::Max(BytesWritten, 0));
+			bPipeTookChunk = BytesWritten == ChunkBytes;
+			if (InputWritten >= Input.size())
+			{
+				// Closing the write end is the child's end-of-file
+				FPlatformProcess::ClosePipe(nullptr, StdInWrite);
+				StdInWrite = nullptr;
+			}
+		}
+#endif
+		if (FPlatformTime::Seconds() >= Deadline)
+		{
+			UE_LOG(LogWakaTime, Warning, TEXT("%s did not finish in %d ms, terminating it"), *ExePath, WaitMs);
+			FPlatformProcess::TerminateProc(Process, true);
+			break;
+		}
+		if (Cancel && *Cancel)
+		{
+			UE_LOG(LogWakaTime, Log, TEXT("Cancelled %s, terminating it"), *ExePath);
+			FPlatformProcess::TerminateProc(Process, true);
+			break;
+		}
+		// A pipe with room for more is filled right away; otherwise give the child time to read
+		if (!bPipeTookChunk || !StdInWrite)
+		{
+			FPlatformProcess::Sleep(0.01f);
+		}
+	}
 
-	if (bRequireNonZeroProcess)
+	if (StdInWrite)
 	{
-		DWORD ExitCode;
-		GetExitCodeProcess(Process_Information.hProcess, &ExitCode);
-		bReturnValue = (ExitCode == 0);
+		FPlatformProcess::ClosePipe(nullptr, StdInWrite);
 	}
-	else
+	// A child that is gone before it got all of its input only saw part of it, whatever it exits with
+	if (!bInputFailed && InputWritten < Input.size())
 	{
-		bReturnValue = true;
+		UE_LOG(LogWakaTime, Warning, TEXT("%s only got %llu of %llu bytes of input"), *ExePath,
+		       static_cast<uint64>(InputWritten), static_cast<uint64>(Input.size()));
+		bInputFailed = true;
 	}
 
-	WaitForSingleObject(Process_Information.hProcess, WaitMs);
-	
-	CloseHandle(Process_Information.hThread);
-	CloseHandle(Process_Information.hProcess);
+	int32 ReturnCode = -1;
+	bool bExited = FPlatformProcess::GetProcReturnCode(Process, &ReturnCode);
+	FPlatformProcess::CloseProc(Process);
 
-	return bSuccess && bReturnValue;
+	return bExited && ReturnCode == 0 && !bInputFailed;
 }
 
 
-bool FWakaTimeHelpers::RunPowershellCommand(std::string CommandToRun, bool bRequireNonZeroProcess, int WaitMs,
-                                            bool bRunPure,
-                                            std::string Directory)
+bool FWakaTimeHelpers::SupportsProcessInput()
 {
-	return RunCommand(CommandToRun, bRequireNonZeroProcess,
-	                  "C:\\Windows\\System32\\WindowsPowerShell\\v1.0\\powershell.exe", WaitMs,
-	                  bRunPure, Directory);
+#if ENGINE_MAJOR_VERSION >= 5
+	return true;
+#else // FPlatformProcess::CreatePipe can't keep the write end out of the child before UE5
+	return false;
+#endif
 }
 
 
-bool FWakaTimeHelpers::RunCmdCommand(std::string CommandToRun, bool bRequireNonZeroProcess, int WaitMs, bool bRunPure,
-                                     std::string Directory)
+std::string FWakaTimeHelpers::QuoteArgument(const std::string& Argument)
 {
-	return RunCommand(CommandToRun, bRequireNonZeroProcess, "C:\\Windows\\System32\\cmd.exe", WaitMs,
-	                  bRunPure, Directory);
+	if (!Argument.empty() && Argument.find_first_of(" \t\n\v\"") == std::string::npos)
+	{
+		return Argument;
+	}
+
+	// Backslashes are only special in front of a quote, where they have to be doubled
+	std::string Quoted = "\"";
+	size_t Backslashes = 0;
+	for (char Char : Argument)
+	{
+		if (Char == '\\')
+		{
+			Backslashes++;
+			continue;
+		}
+
+		if (Char == '"')
+		{
+			Quoted.append(Backslashes * 2 + 1, '\\');
+		}
+		else
+		{
+			Quoted.append(Backslashes, '\\');
+		}
+		Backslashes = 0;
+		Quoted += Char;
+	}
+	Quoted.append(Backslashes * 2, '\\');
+	Quoted += '"';
+	return Quoted;
 }
 
 
-bool FWakaTimeHelpers::UnzipArchive(std::string ZipFile, std::string SavePath)
+void FWakaTimeHelpers::AppendJsonString(std::string& Out, const std::string& Value)
 {
-	if (!PathExists(ZipFile)) return false;
+	static const char* HexDigits = "0123456789abcdef";
 
-	std::string ExtractCommand = "powershell -command \"Expand-Archive -Force \"" + ZipFile + "\" \"" + SavePath + "\"";
-	return RunPowershellCommand(ExtractCommand, false, INFINITE, true);
+	Out += '"';
+	for (char Char : Value)
+	{
+		switch (Char)
+		{
+		case '"': Out += "\\\""; break;
+		case '\\': Out += "\\\\"; break;
+		case '\n': Out += "\\n"; break;
+		case '\r': Out += "\\r"; break;
+		case '\t': Out += "\\t"; break;
+		default:
+			if (static_cast<unsigned char>(Char) < 0x20)
+			{
+				Out += "\\u00";
+				Out += HexDigits[(Char >> 4) & 0xF];
+				Out += HexDigits[Char & 0xF];
+			}
+			else
+			{
+				Out += Char;
+			}
+			break;
+		}
+	}
+	Out += '"';
 }
 
 
-bool FWakaTimeHelpers::DownloadFile(std::string URL, std::string SaveTo)
+bool FWakaTimeHelpers::UnzipArchive(std::string ZipFile, std::string SavePath)
 {
-	std::string DownloadCommand = "powershell -command \"(new-object System.Net.WebClient).DownloadFile('" + URL + "','"
-		+
-		SaveTo + "')\"";
+	if (!PathExists(ZipFile)) return false;
 
-	UE_LOG(LogWakaTime, Warning, TEXT("%s"), *FString(UTF8_TO_TCHAR(DownloadCommand.c_str())));
-	return RunPowershellCommand(DownloadCommand, false, INFINITE, true);
+#if PLATFORM_WINDOWS
+	std::string ExtractCommand = "Expand-Archive -Force -LiteralPath '" + ZipFile + "' -DestinationPath '" + SavePath + "'";
+	return RunProcess(PowershellExe, {"-NoProfile", "-NonInteractive", "-Command", ExtractCommand});
+#else
+	return RunProcess(UnzipExe, {"-o", "-q", ZipFile, "-d", SavePath});
+#endif
 }
+
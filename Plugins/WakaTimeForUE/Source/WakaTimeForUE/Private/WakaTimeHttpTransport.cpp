@@ -0,0 +1,189 @@
+#include "WakaTimeHttpTransport.h"
+
+#include <atomic>
+#include "HAL/IConsoleManager.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/Base64.h"
+#include "Misc/ScopeLock.h"
+#include "Dom/JsonObject.h"
+#include "Dom/JsonValue.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "HttpModule.h"
+#include "Interfaces/IHttpRequest.h"
+#include "Interfaces/IHttpResponse.h"
+#include "WakaTimeForUE.h"
+#include "WakaTimeHeartbeatQueue.h"
+#include "WakaTimeStats.h"
+
+static TAutoConsoleVariable<bool> CVarWakaTimeUseNativeHttp(
+	TEXT("WakaTime.UseNativeHttp"),
+	false,
+	TEXT("Send heartbeats through the engine's HTTP module instead of starting wakatime-cli. ")
+	TEXT("Batches that can't be delivered still go to the CLI, which queues them while offline."));
+
+// Same as wakatime-cli's default api_url
+static const TCHAR* DefaultApiUrl = TEXT("https://api.wakatime.com/api/v1");
+
+static const float HttpTimeoutSeconds = 15.0f;
+
+/// <summary>
+///	Reads the per-heartbeat statuses out of a heartbeats.bulk answer: {"responses": [[{...}, 201], [{...}, 400]]}
+/// </summary>
+/// <returns> False if the body does not have one status per heartbeat </returns>
+static bool ParseBulkResponses(const FString& Content, int32 NumHeartbeats, TArray<int32>& OutFailed)
+{
+	TSharedPtr<FJsonObject> Root;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Content);
+	const TArray<TSharedPtr<FJsonValue>>* Responses = nullptr;
+	if (!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid()
+		|| !Root->TryGetArrayField(TEXT("responses"), Responses) || Responses->Num() != NumHeartbeats)
+	{
+		return false;
+	}
+
+	for (int32 Index = 0; Index < Responses->Num(); Index++)
+	{
+		const TArray<TSharedPtr<FJsonValue>>* Pair = nullptr;
+		double Status = 0.0;
+		if (!(*Responses)[Index]->TryGetArray(Pair) || Pair->Num() < 2 || !(*Pair)[1]->TryGetNumber(Status))
+		{
+			return false;
+		}
+		if (Status < 200 || Status >= 300)
+		{
+			OutFailed.Add(Index);
+		}
+	}
+	return true;
+}
+
+bool FWakaTimeHttpTransport::IsEnabled() const
+{
+#if ENGINE_MAJOR_VERSION >= 5
+	if (!CVarWakaTimeUseNativeHttp.GetValueOnAnyThread())
+	{
+		return false;
+	}
+
+	FScopeLock ScopeLock(&Lock);
+	return !Authorization.IsEmpty();
+#else // requests can't complete off the game thread before UE5, so the workers can't wait for them
+	return false;
+#endif
+}
+
+void FWakaTimeHttpTransport::Configure(const std::string& ApiUrl, const std::string& ApiKey,
+                                       const std::string& PluginVersion)
+{
+	FString BaseUrl = ApiUrl.empty() ? FString(DefaultApiUrl) : FString(UTF8_TO_TCHAR(ApiUrl.c_str())).TrimStartAndEnd();
+	BaseUrl.RemoveFromEnd(TEXT("/"));
+
+	FString Key = FString(UTF8_TO_TCHAR(ApiKey.c_str())).TrimStartAndEnd();
+
+	FScopeLock ScopeLock(&Lock);
+	BulkUrl = BaseUrl + TEXT("/users/current/heartbeats.bulk");
+	Authorization = Key.IsEmpty() ? FString() : TEXT("Basic ") + FBase64::Encode(Key);
+	UserAgent = FString::Printf(TEXT("wakatime/unset (%s) unreal-wakatime/%s"),
+	                            ANSI_TO_TCHAR(FPlatformProperties::IniPlatformName()),
+	                            UTF8_TO_TCHAR(PluginVersion.c_str()));
+}
+
+bool FWakaTimeHttpTransport::Send(const TArray<FWakaTimeHeartbeat>& Batch, const FThreadSafeBool& bCancel,
+                                  TArray<int32>& OutFailed)
+{
+	OutFailed.Reset();
+#if ENGINE_MAJOR_VERSION >= 5
+	WAKATIME_FORUE_SCOPE(HttpSend);
+
+	FString Url;
+	FString Auth;
+	FString Agent;
+	{
+		FScopeLock ScopeLock(&Lock);
+		Url = BulkUrl;
+		Auth = Authorization;
+		Agent = UserAgent;
+	}
+
+	std::string Body = "[";
+	for (int32 Index = 0; Index < Batch.Num(); Index++)
+	{
+		if (Index > 0)
+		{
+			Body += ",";
+		}
+		Body += Batch[Index].Json;
+	}
+	Body += "]";
+
+	// Outlives this call if we stop waiting, since the request still completes later
+	struct FCompletion
+	{
+		FEvent* Done = FPlatformProcess::GetSynchEventFromPool(true);
+		std::atomic<int32> ResponseCode{0};
+		FString Content;
+		~FCompletion() { FPlatformProcess::ReturnSynchEventToPool(Done); }
+	};
+	TSharedPtr<FCompletion, ESPMode::ThreadSafe> Completion = MakeShared<FCompletion, ESPMode::ThreadSafe>();
+
+	TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = FHttpModule::Get().CreateRequest();
+	Request->SetURL(Url);
+	Request->SetVerb(TEXT("POST"));
+	Request->SetHeader(TEXT("Content-Type"), TEXT("application/json"));
+	Request->SetHeader(TEXT("Authorization"), Auth);
+	Request->SetHeader(TEXT("User-Agent"), Agent);
+	Request->SetContent(TArray<uint8>(reinterpret_cast<const uint8*>(Body.data()), static_cast<int32>(Body.size())));
+	Request->SetTimeout(HttpTimeoutSeconds);
+
+	// Complete on the HTTP thread, so waiting here never depends on the game thread
+	Request->SetDelegateThreadPolicy(EHttpRequestDelegateThreadPolicy::CompleteOnHttpThread);
+	Request->OnProcessRequestComplete().BindLambda(
+		[Completion](FHttpRequestPtr, FHttpResponsePtr Response, bool bSucceeded)
+		{
+			Completion->ResponseCode = bSucceeded && Response.IsValid() ? Response->GetResponseCode() : 0;
+			if (Response.IsValid())
+			{
+				Completion->Content = Response->GetContentAsString();
+			}
+			Completion->Done->Trigger();
+		});
+
+	if (!Request->ProcessRequest())
+	{
+		return false;
+	}
+
+	while (!Completion->Done->Wait(100))
+	{
+		if (bCancel)
+		{
+			Request->CancelRequest();
+			return false;
+		}
+	}
+
+	int32 ResponseCode = Completion->ResponseCode;
+	if (ResponseCode < 200 || ResponseCode >= 300)
+	{
+		UE_LOG(LogWakaTime, Warning, TEXT("Heartbeat request to %s failed with code %d"), *Url, ResponseCode);
+		return false;
+	}
+
+	// The request went through, but every heartbeat has its own status. An answer we can't read is taken as
+	// accepted, the same as a plain 2xx
+	if (!ParseBulkResponses(Completion->Content, Batch.Num(), OutFailed))
+	{
+		UE_LOG(LogWakaTime, Verbose, TEXT("Unexpected heartbeats.bulk answer, taking the whole batch as accepted"));
+		OutFailed.Reset();
+	}
+	else if (OutFailed.Num() > 0)
+	{
+		UE_LOG(LogWakaTime, Warning, TEXT("API rejected %d of %d heartbeats"), OutFailed.Num(), Batch.Num());
+	}
+	return true;
+#else
+	return false;
+#endif
+}
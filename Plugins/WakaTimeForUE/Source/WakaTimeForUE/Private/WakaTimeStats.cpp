@@ -0,0 +1,68 @@
+#include "WakaTimeStats.h"
+
+UE_TRACE_CHANNEL_DEFINE(WakaTimeForUEChannel)
+
+DEFINE_STAT(STAT_WakaTimeForUE_OnNewActorDropped);
+DEFINE_STAT(STAT_WakaTimeForUE_OnDuplicateActorsEnd);
+DEFINE_STAT(STAT_WakaTimeForUE_OnDeleteActorsEnd);
+DEFINE_STAT(STAT_WakaTimeForUE_OnAddLevelToWorld);
+DEFINE_STAT(STAT_WakaTimeForUE_OnPostSaveWorld);
+DEFINE_STAT(STAT_WakaTimeForUE_OnPostPieStarted);
+DEFINE_STAT(STAT_WakaTimeForUE_OnPrePieEnded);
+DEFINE_STAT(STAT_WakaTimeForUE_OnPieTick);
+DEFINE_STAT(STAT_WakaTimeForUE_OnBlueprintPreCompile);
+DEFINE_STAT(STAT_WakaTimeForUE_OnBlueprintCompiled);
+DEFINE_STAT(STAT_WakaTimeForUE_SendHeartbeat);
+DEFINE_STAT(STAT_WakaTimeForUE_HttpSend);
+DEFINE_STAT(STAT_WakaTimeForUE_SchedulerTick);
+
+DEFINE_STAT(STAT_WakaTimeForUE_EventsNewActorDropped);
+DEFINE_STAT(STAT_WakaTimeForUE_EventsDuplicateActorsEnd);
+DEFINE_STAT(STAT_WakaTimeForUE_EventsDeleteActorsEnd);
+DEFINE_STAT(STAT_WakaTimeForUE_EventsAddLevelToWorld);
+DEFINE_STAT(STAT_WakaTimeForUE_EventsPostSaveWorld);
+DEFINE_STAT(STAT_WakaTimeForUE_EventsPostPieStarted);
+DEFINE_STAT(STAT_WakaTimeForUE_EventsPrePieEnded);
+DEFINE_STAT(STAT_WakaTimeForUE_EventsBlueprintPreCompile);
+DEFINE_STAT(STAT_WakaTimeForUE_HeartbeatsQueued);
+DEFINE_STAT(STAT_WakaTimeForUE_HeartbeatsSent);
+DEFINE_STAT(STAT_WakaTimeForUE_HeartbeatsFailed);
+DEFINE_STAT(STAT_WakaTimeForUE_PayloadBytes);
+DEFINE_STAT(STAT_WakaTimeForUE_HttpFallbacks);
+DEFINE_STAT(STAT_WakaTimeForUE_HeartbeatsDebounced);
+DEFINE_STAT(STAT_WakaTimeForUE_BudgetOverruns);
+DEFINE_STAT(STAT_WakaTimeForUE_HeartbeatsDeduplicated);
+DEFINE_STAT(STAT_WakaTimeForUE_DedupHitRate);
+
+DEFINE_STAT(STAT_WakaTimeForUE_Latency100ms);
+DEFINE_STAT(STAT_WakaTimeForUE_Latency500ms);
+DEFINE_STAT(STAT_WakaTimeForUE_Latency2s);
+DEFINE_STAT(STAT_WakaTimeForUE_LatencyOver2s);
+
+TRACE_DECLARE_INT_COUNTER(WakaTimeForUE_HeartbeatsQueued, TEXT("Wakatime/ForUE/HeartbeatsQueued"));
+TRACE_DECLARE_INT_COUNTER(WakaTimeForUE_HeartbeatsSent, TEXT("Wakatime/ForUE/HeartbeatsSent"));
+TRACE_DECLARE_INT_COUNTER(WakaTimeForUE_HeartbeatsFailed, TEXT("Wakatime/ForUE/HeartbeatsFailed"));
+TRACE_DECLARE_MEMORY_COUNTER(WakaTimeForUE_PayloadBytes, TEXT("Wakatime/ForUE/PayloadBytes"));
+TRACE_DECLARE_FLOAT_COUNTER(WakaTimeForUE_RequestLatencyMs, TEXT("Wakatime/ForUE/RequestLatencyMs"));
+
+void WakaTimeStats::RecordRequestLatency(double Seconds)
+{
+	TRACE_COUNTER_SET(WakaTimeForUE_RequestLatencyMs, Seconds * 1000.0);
+
+	if (Seconds < 0.1)
+	{
+		INC_DWORD_STAT(STAT_WakaTimeForUE_Latency100ms);
+	}
+	else if (Seconds < 0.5)
+	{
+		INC_DWORD_STAT(STAT_WakaTimeForUE_Latency500ms);
+	}
+	else if (Seconds < 2.0)
+	{
+		INC_DWORD_STAT(STAT_WakaTimeForUE_Latency2s);
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_WakaTimeForUE_LatencyOver2s);
+	}
+}
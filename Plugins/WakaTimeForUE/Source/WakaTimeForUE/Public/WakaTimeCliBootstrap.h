@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "Interfaces/IHttpRequest.h"
+
+/// <summary>
+///	Installs wakatime-cli in the background when it is missing, so editor startup never waits for it.
+///	The archive is fetched with FHttpModule (or read directly for file:// URLs), the CLI is extracted in-process
+///	on a pool thread next to its final location and then renamed into place, so other processes never see a
+///	half-written binary.
+/// </summary>
+class FWakaTimeCliBootstrap
+{
+public:
+	/// <summary>
+	///	Called on the game thread once the bootstrap is over
+	/// </summary>
+	/// <param name="bSuccess"> Whether the CLI is now installed </param>
+	typedef TFunction<void(bool bSuccess)> FOnFinished;
+
+	/// <summary>
+	///	Starts downloading and installing the CLI. Returns immediately
+	/// </summary>
+	/// <param name="InCliPath"> Where the CLI executable should end up </param>
+	/// <param name="Url"> Release archive to install from; http(s):// or file:// </param>
+	/// <param name="InOnFinished"> Result callback, invoked on the game thread </param>
+	void Start(const std::string& InCliPath, const FString& Url, FOnFinished InOnFinished);
+
+	/// <summary>
+	///	Cancels the download and waits for a running extraction; the callback is not invoked afterwards
+	/// </summary>
+	void Shutdown();
+
+	/// <summary>
+	///	URL of the release archive for this platform, unless WakaTime.CliDownloadUrl overrides it
+	/// </summary>
+	/// <param name="OS"> windows, linux or darwin </param>
+	/// <param name="Architecture"> amd64 or arm64 </param>
+	static FString GetDownloadUrl(const std::string& OS, const std::string& Architecture);
+
+private:
+	/// <summary>
+	///	Download finished; hands the archive over to a pool thread
+	/// </summary>
+	void OnDownloadComplete(FHttpRequestPtr HttpRequest, FHttpResponsePtr Response, bool bSucceeded);
+
+	/// <summary>
+	///	Extracts the CLI and renames it into place. Runs on a pool thread
+	/// </summary>
+	/// <param name="ZipPath"> Archive on disk </param>
+	/// <param name="bDeleteZip"> Whether the archive is a temporary file that should be removed afterwards </param>
+	bool Install(const FString& ZipPath, bool bDeleteZip) const;
+
+	/// <summary>
+	///	Reports the result on the game thread
+	/// </summary>
+	void Finish(bool bSuccess);
+
+	FString CliPath;
+	FHttpRequestPtr Request;
+	TFuture<void> InstallTask;
+	FOnFinished OnFinished;
+	TSharedPtr<bool, ESPMode::ThreadSafe> AliveToken;
+	TWeakPtr<bool, ESPMode::ThreadSafe> WeakAliveToken;
+};
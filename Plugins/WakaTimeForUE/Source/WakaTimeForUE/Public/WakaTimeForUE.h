@@ -4,9 +4,28 @@
 #include <map>
 #include <Runtime/SlateCore/Public/Styling/SlateStyle.h>
 #include "EditorStyleSet.h"
+#include "WakaTimeHeartbeatQueue.h"
+#include "WakaTimeHttpTransport.h"
+#include "WakaTimeCliBootstrap.h"
+#include "WakaTimeHeartbeatScheduler.h"
+#include "WakaTimeFrameBudget.h"
+#include "WakaTimeHeartbeatDedup.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogWakaTime, Log, All);
 
+struct FFileChangeData;
+
+/// <summary>
+///	Contents of ~/.wakatime.cfg the plugin cares about
+/// </summary>
+struct FWakaTimeConfig
+{
+	std::string ApiKey;
+	std::string ApiUrl;
+	bool bFoundApiKey = false;
+	bool bFoundApiUrl = false;
+};
+
 class FWakaTimeForUEModule : public IModuleInterface
 {
 public:
@@ -39,17 +58,37 @@ public:
 	void HandleStartupApiCheck(std::string ConfigFilePath);
 
 	/// <summary>
-	///	Checks whether the wakatime config file exists and includes the api_key
+	///	Parses the wakatime config file into Config
 	/// </summary>
 	/// <param name="ConfigFilePath"> Path to the config file directory</param>
-	void ReadConfig(std::string ConfigFilePath, bool& bFoundApiKey, bool& bFoundApiUrl);
+	void ReadConfig(std::string ConfigFilePath);
+
+	/// <summary>
+	///	Replaces the cached config and passes it on to whoever depends on it
+	/// </summary>
+	void ApplyConfig(const FWakaTimeConfig& NewConfig);
 
 	/// <summary>
-	///	Checks if Wakatime exists, if not, downloads it using Powershell
+	///	Directory watcher callback for the user's home directory; re-reads the config if it was among the changes
+	/// </summary>
+	void OnConfigDirectoryChanged(const TArray<FFileChangeData>& FileChanges);
+
+	/// <summary>
+	///	Checks if Wakatime exists, if not, installs it in the background; heartbeats are held until it is ready
 	/// </summary>
 	/// <param name="CliPath"> Path to the wakatime exe file </param>
 	void DownloadWakatimeCli(std::string CliPath);
 
+	/// <summary>
+	///	Subscribes to the level editor events (actors placed, duplicated or deleted, levels added, world saved)
+	/// </summary>
+	void BindEditorEvents();
+
+	/// <summary>
+	///	Unsubscribes from the level editor events; used while Play-In-Editor runs and on shutdown
+	/// </summary>
+	void UnbindEditorEvents();
+
 	/// <summary>
 	///	Returns the name of the project
 	/// </summary>
@@ -71,15 +110,20 @@ public:
 	void AddToolbarButton(FToolBarBuilder& Builder);
 
 	/// <summary>
-	///	Called when the toolbar icon is clicked; Reads config and opens the Slate window
+	///	Called when the toolbar icon is clicked; opens the Slate window with the cached config
 	/// </summary>
 	void OpenSettingsWindowFromUI();
 	
 	/// <summary>
-	///	Opens the Slate window
+	///	Builds and opens the Slate window
 	/// </summary>
 	void OpenSettingsWindow();
 
+	/// <summary>
+	///	Closes the Slate window and releases its widgets
+	/// </summary>
+	void CloseSettingsWindow();
+
 	/// <summary>
 	///	Called when user clicks "Save" within the slate window.
 	///	Saves the entered api key into the wakatime.cfg file
@@ -98,7 +142,18 @@ public:
 	/// <param name="bFileSave"> whether to attach the file that is being worked on </param>
 	/// <param name="FilePath"> path to the current file that is being edited </param>
 	/// <param name="Activity"> activity being performed by the user while sending the heartbeat; e.g. coding, designing, debugging, etc. </param>
-	void SendHeartbeat(bool bFileSave, std::string Activity, std::string EntityType, FString Entity, std::string Language);
+	/// <param name="Time"> unix time of the activity; 0 for now </param>
+	/// <remarks> Dropped if the server would discard it, see FWakaTimeHeartbeatDedup </remarks>
+	void SendHeartbeat(bool bFileSave, std::string Activity, std::string EntityType, FString Entity, std::string Language,
+	                   double Time = 0.0);
+
+	/// <summary>
+	///	Called on the game thread once the heartbeat queue handed a batch of heartbeats to wakatime-cli
+	/// </summary>
+	/// <param name="bSuccess"> Whether the CLI ran and accepted the batch </param>
+	/// <param name="ErrorCode"> Platform error code if it did not </param>
+	/// <param name="NumHeartbeats"> Number of heartbeats in the batch </param>
+	void OnHeartbeatFinished(bool bSuccess, uint32 ErrorCode, int32 NumHeartbeats);
 
 
 	// Event methods
@@ -143,9 +198,20 @@ public:
 	void OnPrePieEnded(bool bIsSimulating);
 
 	/// <summary>
-	///	Event called prior to blueprint compiling
+	///	Sends a debugging heartbeat every WakaTime.PieHeartbeatInterval seconds while Play-In-Editor runs
+	/// </summary>
+	bool OnPieTick(float DeltaTime);
+
+	/// <summary>
+	///	Event called prior to blueprint compiling; only notes the blueprint, the heartbeat is sent by OnBlueprintCompiled
 	/// </summary>
 	void OnBlueprintPreCompile(UBlueprint* Blueprint);
+
+	/// <summary>
+	///	Event called once a batch of blueprint compiles (a single compile, Compile All, a reparent...) is done.
+	///	Sends one heartbeat per distinct blueprint compiled in the batch, or a single one for the batch while over the frame budget
+	/// </summary>
+	void OnBlueprintCompiled();
 	
 	/// <summary>
 	///	Event called when editor window is initialized
@@ -165,8 +231,24 @@ public:
 #endif
 
 	TSharedPtr<FUICommandList> PluginCommands;
+	FWakaTimeConfig Config;
+	FWakaTimeHttpTransport HttpTransport;
+	FWakaTimeHeartbeatQueue HeartbeatQueue;
+	FWakaTimeCliBootstrap CliBootstrap;
+	FWakaTimeHeartbeatScheduler HeartbeatScheduler;
+	FWakaTimeFrameBudget FrameBudget;
+	FWakaTimeHeartbeatDedup HeartbeatDedup;
+#if ENGINE_MAJOR_VERSION >= 5
+	FTSTicker::FDelegateHandle PieTickerHandle;
+#else
+	FDelegateHandle PieTickerHandle;
+#endif
 #if ENGINE_MAJOR_VERSION >= 5 && ENGINE_MINOR_VERSION >= 4 // RedTheKitsune(OnAssetClosedInEditor is not available in <UE5.4, so blueprint name tracking will not work properly)
-	TArray<TSharedRef<FString>> OpenedBPs;
+	// Package names of blueprints open in an editor, and of those compiled since the last OnBlueprintCompiled
+	TSet<FName> OpenedBPs;
+	TSet<FName> CompiledBPs;
+#else
+	bool bBlueprintCompiled = false;
 #endif
 };
 
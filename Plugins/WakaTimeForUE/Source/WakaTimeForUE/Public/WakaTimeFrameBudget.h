@@ -0,0 +1,60 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/// <summary>
+///	Measures how much game-thread time the plugin's editor callbacks take per frame. A frame costing more than
+///	WakaTime.FrameBudget microseconds switches the plugin to degraded mode; WakaTime.FrameBudgetRecoveryFrames
+///	cheap frames switch it back, and the owner is notified both times. Wrap each callback in an FScope; nested
+///	scopes and scopes on other threads add nothing.
+/// </summary>
+class FWakaTimeFrameBudget
+{
+public:
+	/// <summary>
+	///	Times one callback
+	/// </summary>
+	class FScope
+	{
+	public:
+		explicit FScope(FWakaTimeFrameBudget& InBudget);
+		~FScope();
+
+	private:
+		FWakaTimeFrameBudget& Budget;
+		uint64 StartCycles = 0;
+		bool bCounted = false;
+	};
+
+	/// <summary>
+	///	Called on the game thread when the plugin enters or leaves degraded mode
+	/// </summary>
+	typedef TFunction<void(bool bDegraded)> FOnDegradedChanged;
+
+	/// <summary>
+	///	Sets who hears about mode changes; commandlets never advance the frame counter, so they keep the guard off
+	/// </summary>
+	void Initialize(FOnDegradedChanged InOnDegradedChanged);
+
+	bool IsDegraded() const
+	{
+		return bDegraded;
+	}
+
+private:
+	/// <summary>
+	///	Settles the frame that just ended and picks up CVar changes
+	/// </summary>
+	void AdvanceFrame();
+
+	void SetDegraded(bool bInDegraded);
+
+	FOnDegradedChanged OnDegradedChanged;
+	bool bEnabled = false;
+	uint64 BudgetCycles = 0;
+	uint64 Frame = 0;
+	uint64 FrameCycles = 0;
+	uint64 QuietFrames = 0;
+	int32 Depth = 0;
+	bool bDegraded = false;
+};
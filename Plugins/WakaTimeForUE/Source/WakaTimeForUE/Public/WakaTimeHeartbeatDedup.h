@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include "CoreMinimal.h"
+#include "Containers/LruCache.h"
+
+/// <summary>
+///	Filters out heartbeats the WakaTime API ignores, i.e. a repeat of the same category and entity with the same
+///	is_write less than two minutes after the last one. Checked before the queue, so those repeats cost neither a
+///	wakatime-cli process nor an HTTP request. Remembers the last InMaxEntries keys. Game thread only.
+/// </summary>
+class FWakaTimeHeartbeatDedup
+{
+public:
+	explicit FWakaTimeHeartbeatDedup(int32 InMaxEntries = 128);
+
+	/// <summary>
+	///	Whether the heartbeat is worth sending; remembers it if so
+	/// </summary>
+	/// <param name="Activity"> Heartbeat category </param>
+	/// <param name="Entity"> File path or app name </param>
+	/// <param name="bIsWrite"> Whether the heartbeat saved something </param>
+	/// <param name="Time"> Unix time of the heartbeat </param>
+	bool ShouldSend(const std::string& Activity, const FString& Entity, bool bIsWrite, double Time);
+
+	/// <summary>
+	///	Share of heartbeats dropped so far, 0 to 1
+	/// </summary>
+	double GetHitRate() const
+	{
+		return Lookups > 0 ? static_cast<double>(Hits) / Lookups : 0.0;
+	}
+
+private:
+	struct FSent
+	{
+		double Time = 0.0;
+		bool bIsWrite = false;
+	};
+
+	TLruCache<FString, FSent> Sent;
+	uint64 Lookups = 0;
+	uint64 Hits = 0;
+};
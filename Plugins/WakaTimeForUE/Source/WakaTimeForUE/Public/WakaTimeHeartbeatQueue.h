@@ -0,0 +1,117 @@
+#pragma once
+
+#include <string>
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+
+class FRunnableThread;
+class FEvent;
+class FWakaTimeHttpTransport;
+
+/// <summary>
+///	One heartbeat, prepared on the game thread in both forms the CLI accepts
+/// </summary>
+struct FWakaTimeHeartbeat
+{
+	/// <summary>
+	///	Command line arguments for wakatime-cli when this heartbeat leads a batch, one per element
+	/// </summary>
+	TArray<std::string> Arguments;
+
+	/// <summary>
+	///	JSON object for --extra-heartbeats when it does not
+	/// </summary>
+	std::string Json;
+
+	double QueuedTime = 0.0;
+};
+
+/// <summary>
+///	Runs heartbeats through wakatime-cli on a small pool of background threads, so launching the CLI never
+///	blocks the game thread. Heartbeats are collected for a short window and sent with a single CLI process:
+///	the first one as arguments, the rest as a JSON array on stdin via --extra-heartbeats. The queue is bounded
+///	(the oldest heartbeat is dropped when it overflows) and so is the number of processes running at once.
+///	With a native HTTP transport enabled, batches are posted directly; the CLI only gets a batch the request
+///	failed for, or the heartbeats the API rejected.
+///	Results are reported back on the game thread.
+/// </summary>
+class FWakaTimeHeartbeatQueue : public FRunnable
+{
+public:
+	/// <summary>
+	///	Called on the game thread after a batch of heartbeats was handed to the CLI
+	/// </summary>
+	/// <param name="bSuccess"> Whether the CLI ran and accepted the batch </param>
+	/// <param name="ErrorCode"> Last platform error of the worker thread if it did not </param>
+	/// <param name="NumHeartbeats"> Number of heartbeats in the batch </param>
+	typedef TFunction<void(bool bSuccess, uint32 ErrorCode, int32 NumHeartbeats)> FOnHeartbeatFinished;
+
+	/// <summary>
+	///	Starts the worker threads
+	/// </summary>
+	/// <param name="InCliPath"> Path to the wakatime-cli executable </param>
+	/// <param name="InMaxConcurrency"> How many CLI processes may run at the same time </param>
+	/// <param name="InCapacity"> How many heartbeats may wait in the queue </param>
+	/// <param name="InOnFinished"> Result callback, invoked on the game thread </param>
+	/// <param name="InTransport"> Optional in-process transport tried before the CLI; must outlive the queue </param>
+	void Start(std::string InCliPath, int32 InMaxConcurrency, int32 InCapacity, FOnHeartbeatFinished InOnFinished,
+	           FWakaTimeHttpTransport* InTransport = nullptr);
+
+	/// <summary>
+	///	Stops the worker threads, cancelling any CLI process they are waiting on, then sends whatever is still
+	///	queued from the calling thread. That last flush is limited to a few seconds in total
+	/// </summary>
+	void Shutdown();
+
+	/// <summary>
+	///	Queues a heartbeat. Never blocks
+	/// </summary>
+	void Enqueue(FWakaTimeHeartbeat Heartbeat);
+
+	/// <summary>
+	///	Holds heartbeats in the queue (e.g. while the CLI is still being installed) until Resume is called
+	/// </summary>
+	void Pause();
+
+	/// <summary>
+	///	Lets the workers pick up heartbeats again
+	/// </summary>
+	void Resume();
+
+	// FRunnable
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	/// <summary>
+	///	Takes the next batch once its window has passed (or it is full). Waits for at most WaitMs
+	/// </summary>
+	bool DequeueBatch(TArray<FWakaTimeHeartbeat>& OutBatch, uint32& OutWaitMs);
+
+	/// <summary>
+	///	Runs one CLI process for the whole batch
+	/// </summary>
+	/// <param name="Batch"> Heartbeats to send, the first one leads </param>
+	/// <param name="WaitMs"> How long the process may run before it is terminated </param>
+	/// <param name="Cancel"> Terminates the process early once set; may be null </param>
+	bool RunBatch(const TArray<FWakaTimeHeartbeat>& Batch, int WaitMs, const FThreadSafeBool* Cancel);
+
+	/// <summary>
+	///	Posts a result to OnFinished on the game thread, unless the queue was shut down by then
+	/// </summary>
+	void ReportFinished(bool bSuccess, uint32 ErrorCode, int32 NumHeartbeats);
+
+	std::string CliPath;
+	FWakaTimeHttpTransport* Transport = nullptr;
+	FCriticalSection Lock;
+	TArray<FWakaTimeHeartbeat> Jobs;
+	int32 Capacity = 64;
+	FEvent* WorkAvailable = nullptr;
+	TArray<FRunnableThread*> Threads;
+	FThreadSafeBool bStopping;
+	FThreadSafeBool bPaused;
+	FOnHeartbeatFinished OnFinished;
+	TSharedPtr<bool, ESPMode::ThreadSafe> AliveToken;
+	TWeakPtr<bool, ESPMode::ThreadSafe> WeakAliveToken;
+};
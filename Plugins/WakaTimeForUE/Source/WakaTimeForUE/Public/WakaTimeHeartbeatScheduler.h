@@ -0,0 +1,86 @@
+#pragma once
+
+#include <string>
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+
+/// <summary>
+///	Trailing-edge debounce for editor events. Events are merged per category and entity: the first one opens a
+///	window (WakaTime.DebounceWindow seconds), later ones only update it, and a single heartbeat carrying the
+///	strongest is_write flag and the time of the latest event is sent when the window closes. Deadlines live in a
+///	hashed timer wheel advanced by the core ticker, which only runs while something is pending.
+///	Game thread only.
+/// </summary>
+class FWakaTimeHeartbeatScheduler
+{
+public:
+	/// <summary>
+	///	Sends a merged heartbeat
+	/// </summary>
+	typedef TFunction<void(bool bIsWrite, const std::string& Activity, const std::string& EntityType, const FString& Entity,
+	                       const std::string& Language, double Time)> FSendHeartbeat;
+
+	/// <summary>
+	///	Sets where merged heartbeats go
+	/// </summary>
+	void Initialize(FSendHeartbeat InSend);
+
+	/// <summary>
+	///	Sends everything that is pending right away and stops the ticker
+	/// </summary>
+	void Shutdown();
+
+	/// <summary>
+	///	Records an event; sends immediately if the debounce window is 0
+	/// </summary>
+	/// <param name="bIsWrite"> Whether the event saved something </param>
+	/// <param name="Activity"> Heartbeat category, e.g. designing </param>
+	/// <param name="EntityType"> file or app </param>
+	/// <param name="Entity"> File path or app name </param>
+	/// <param name="Language"> Language reported with the heartbeat </param>
+	void Schedule(bool bIsWrite, const std::string& Activity, const std::string& EntityType, const FString& Entity,
+	              const std::string& Language);
+
+	/// <summary>
+	///	Stretches the debounce window for events scheduled from now on; used while the plugin is over its frame budget
+	/// </summary>
+	void SetWindowScale(float InWindowScale)
+	{
+		WindowScale = InWindowScale;
+	}
+
+private:
+	struct FPendingHeartbeat
+	{
+		bool bIsWrite = false;
+		std::string Activity;
+		std::string EntityType;
+		FString Entity;
+		std::string Language;
+		double Time = 0.0;
+		double DueTime = 0.0;
+	};
+
+	/// <summary>
+	///	Advances the wheel to now and sends every heartbeat that is due
+	/// </summary>
+	bool Tick(float DeltaTime);
+
+	/// <summary>
+	///	Puts a key into the wheel slot of its deadline
+	/// </summary>
+	void AddToWheel(const FString& Key, double DueTime);
+
+	void Send(const FPendingHeartbeat& Entry) const;
+
+	FSendHeartbeat SendHeartbeat;
+	TMap<FString, FPendingHeartbeat> Pending;
+	TArray<TArray<FString>> Wheel;
+	int64 CurrentTick = 0;
+	float WindowScale = 1.0f;
+#if ENGINE_MAJOR_VERSION >= 5
+	FTSTicker::FDelegateHandle TickerHandle;
+#else
+	FDelegateHandle TickerHandle;
+#endif
+};
@@ -1,6 +1,8 @@
 ﻿#pragma once
 
 #include <string>
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeBool.h"
 
 class FWakaTimeHelpers
 {
@@ -10,63 +12,48 @@ public:
 	/// </summary>
 	/// <param name="Path"> Path to the location </param>
 	/// <returns> True if file or directory exists, false otherwise </returns>
-	/// <remarks> According to StackOverflow - PherricOxide, this is the fastest method to check </remarks>
 	static bool PathExists(const std::string& Path);
 
 	/// <summary>
-	///	Runs a command using an exe file
+	///	Launches an executable directly (no cmd, powershell or shell in between), optionally writes Input to
+	///	its standard input and waits for it to exit
 	/// </summary>
-	/// <param name="CommandToRun"> Command that should be passed to the exe file as arguments </param>
-	/// <param name="bRequireNonZeroProcess"> Also checks for the inner process exit code, requiring it to be non-zero </param>
-	/// <param name="ExeToRun"> Path to the exe </param>
-	/// <param name="WaitMs"> How long to wait for the process to finish </param>
-	/// <param name="bRunPure"> If false, prepends "/c start /b" to the command (mainly for CMD use) </param>
-	/// <param name="Directory"> Path to the directory to start the process in </param>
-	/// <returns> True, if process succeeds (and its return code is non-zero if required) </returns>
-	static bool RunCommand(std::string CommandToRun, bool bRequireNonZeroProcess = false,
-	                       std::string ExeToRun = "C:\\Windows\\System32\\cmd.exe", int WaitMs = 0,
-	                       bool bRunPure = false,
-	                       std::string Directory = "");
+	/// <param name="ExeToRun"> Path to the executable </param>
+	/// <param name="Arguments"> Arguments for the executable, one per element; quoting is handled here </param>
+	/// <param name="Input"> Data written to the process' stdin while waiting, which is closed afterwards; may be
+	/// empty. The run fails if the process doesn't take all of it </param>
+	/// <param name="WaitMs"> How long to wait for the process to finish, negative to wait forever. A process that
+	/// runs longer is terminated </param>
+	/// <param name="Cancel"> Optional flag polled while waiting; the process is terminated once it is set </param>
+	/// <returns> True if the process ran and exited with code 0 </returns>
+	static bool RunProcess(const std::string& ExeToRun, const TArray<std::string>& Arguments,
+	                       const std::string& Input = "", int WaitMs = -1, const FThreadSafeBool* Cancel = nullptr);
 
 	/// <summary>
-	///	Overload for RunCommand that uses Powershell
+	///	Whether RunProcess can pass standard input on this engine version
 	/// </summary>
-	/// <param name="CommandToRun"> Command that should be passed to the exe file as arguments </param>
-	/// <param name="bRequireNonZeroProcess"> Also checks for the inner process exit code, requiring it to be non-zero </param>
-	/// <param name="WaitMs"> How long to wait for the process to finish </param>
-	/// <param name="bRunPure"> If false, prepends "/c start /b" to the command (mainly for CMD use) </param>
-	/// <param name="Directory"> Path to the directory to start the process in </param>
-	/// <returns> True, if process succeeds (and its return code is non-zero if required) </returns>
-	static bool RunPowershellCommand(std::string CommandToRun, bool bRequireNonZeroProcess = false, int WaitMs = 0,
-	                                 bool bRunPure = false,
-	                                 std::string Directory = "");
+	static bool SupportsProcessInput();
 
 	/// <summary>
-	///	Overload for RunCommand that uses Cmd
+	///	Quotes a single argument so the child process sees it unchanged (CommandLineToArgvW rules)
 	/// </summary>
-	/// /// <param name="CommandToRun"> Command that should be passed to the exe file as arguments </param>
-	/// <param name="bRequireNonZeroProcess"> Also checks for the inner process exit code, requiring it to be non-zero </param>
-	/// <param name="WaitMs"> How long to wait for the process to finish </param>
-	/// <param name="bRunPure"> If false, prepends "/c start /b" to the command (mainly for CMD use) </param>
-	/// <param name="Directory"> Path to the directory to start the process in </param>
-	/// <returns> True, if process succeeds (and its return code is non-zero if required) </returns>
-	static bool RunCmdCommand(std::string CommandToRun, bool bRequireNonZeroProcess = false, int WaitMs = 0,
-	                          bool bRunPure = false,
-	                          std::string Directory = "");
+	/// <param name="Argument"> UTF-8 argument </param>
+	/// <returns> The argument, quoted and escaped if needed </returns>
+	static std::string QuoteArgument(const std::string& Argument);
 
 	/// <summary>
-	/// Unzips a .zip archive into a directory using powershell
+	///	Appends Value to Out as a quoted JSON string
 	/// </summary>
-	/// <param name="ZipFile"> Path to the zip file </param>
-	/// <param name="SavePath"> Directory to extract to </param>
-	/// <returns> True if process succeeded </returns>
-	static bool UnzipArchive(std::string ZipFile, std::string SavePath);
+	/// <param name="Out"> String to append to </param>
+	/// <param name="Value"> UTF-8 value to escape </param>
+	static void AppendJsonString(std::string& Out, const std::string& Value);
 
 	/// <summary>
-	/// Downloads a file into a directory using powershell
+	/// Unzips a .zip archive into a directory (powershell on Windows, unzip elsewhere). Only used on engines
+	/// without FZipArchiveReader
 	/// </summary>
-	/// <param name="URL"> Url where to download the file from </param>
-	/// <param name="SaveTo"> Path where to save the file </param>
+	/// <param name="ZipFile"> Path to the zip file </param>
+	/// <param name="SavePath"> Directory to extract to </param>
 	/// <returns> True if process succeeded </returns>
-	static bool DownloadFile(std::string URL, std::string SaveTo);
+	static bool UnzipArchive(std::string ZipFile, std::string SavePath);
 };
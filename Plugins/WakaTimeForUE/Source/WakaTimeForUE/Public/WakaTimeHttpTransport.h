@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeBool.h"
+
+struct FWakaTimeHeartbeat;
+
+/// <summary>
+///	Sends heartbeats from inside the editor through FHttpModule, straight to the configured api_url, without
+///	starting wakatime-cli. Off unless WakaTime.UseNativeHttp is set. When a batch can't be delivered, the caller
+///	falls back to the CLI, which keeps its own offline queue.
+/// </summary>
+class FWakaTimeHttpTransport
+{
+public:
+	/// <summary>
+	///	Whether heartbeats should go through this transport right now: the CVar is on, the engine supports it
+	///	and an api key is known
+	/// </summary>
+	bool IsEnabled() const;
+
+	/// <summary>
+	///	Updates the credentials, called whenever the config file is read or saved
+	/// </summary>
+	/// <param name="ApiUrl"> api_url from the config, empty for the default WakaTime API </param>
+	/// <param name="ApiKey"> api_key from the config </param>
+	/// <param name="PluginVersion"> Version of the plugin, used in the user agent </param>
+	void Configure(const std::string& ApiUrl, const std::string& ApiKey, const std::string& PluginVersion);
+
+	/// <summary>
+	///	Posts a batch to the heartbeats.bulk endpoint and waits for the answer. Called on a heartbeat worker thread
+	/// </summary>
+	/// <param name="Batch"> Heartbeats to send </param>
+	/// <param name="bCancel"> Checked while waiting; the request is cancelled once it becomes true </param>
+	/// <param name="OutFailed"> Indices into Batch of heartbeats the API answered with an error status, even
+	/// though the request itself succeeded </param>
+	/// <returns> True if the API answered the request; OutFailed then says which heartbeats it rejected </returns>
+	bool Send(const TArray<FWakaTimeHeartbeat>& Batch, const FThreadSafeBool& bCancel, TArray<int32>& OutFailed);
+
+private:
+	mutable FCriticalSection Lock;
+	FString BulkUrl;
+	FString Authorization;
+	FString UserAgent;
+};
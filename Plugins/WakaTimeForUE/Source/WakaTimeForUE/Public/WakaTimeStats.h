@@ -0,0 +1,82 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Trace/Trace.h"
+
+// Shares the "stat Wakatime" group with the WakatimeIntegration plugin, so both show up side by side.
+// In Insights, enable the WakaTimeForUE channel (-trace=default,WakaTimeForUE) for per-callback CPU scopes.
+DECLARE_STATS_GROUP(TEXT("Wakatime"), STATGROUP_Wakatime, STATCAT_Advanced);
+
+UE_TRACE_CHANNEL_EXTERN(WakaTimeForUEChannel)
+
+// Time spent inside each callback
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ForUE OnNewActorDropped"), STAT_WakaTimeForUE_OnNewActorDropped, STATGROUP_Wakatime, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ForUE OnDuplicateActorsEnd"), STAT_WakaTimeForUE_OnDuplicateActorsEnd, STATGROUP_Wakatime, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ForUE OnDeleteActorsEnd"), STAT_WakaTimeForUE_OnDeleteActorsEnd, STATGROUP_Wakatime, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ForUE OnAddLevelToWorld"), STAT_WakaTimeForUE_OnAddLevelToWorld, STATGROUP_Wakatime, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ForUE OnPostSaveWorld"), STAT_WakaTimeForUE_OnPostSaveWorld, STATGROUP_Wakatime, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ForUE OnPostPieStarted"), STAT_WakaTimeForUE_OnPostPieStarted, STATGROUP_Wakatime, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ForUE OnPrePieEnded"), STAT_WakaTimeForUE_OnPrePieEnded, STATGROUP_Wakatime, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ForUE OnPieTick"), STAT_WakaTimeForUE_OnPieTick, STATGROUP_Wakatime, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ForUE OnBlueprintPreCompile"), STAT_WakaTimeForUE_OnBlueprintPreCompile, STATGROUP_Wakatime, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ForUE OnBlueprintCompiled"), STAT_WakaTimeForUE_OnBlueprintCompiled, STATGROUP_Wakatime, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ForUE SendHeartbeat"), STAT_WakaTimeForUE_SendHeartbeat, STATGROUP_Wakatime, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ForUE HttpSend (worker)"), STAT_WakaTimeForUE_HttpSend, STATGROUP_Wakatime, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ForUE SchedulerTick"), STAT_WakaTimeForUE_SchedulerTick, STATGROUP_Wakatime, );
+
+// Totals since startup
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("ForUE Events NewActorDropped"), STAT_WakaTimeForUE_EventsNewActorDropped, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("ForUE Events DuplicateActorsEnd"), STAT_WakaTimeForUE_EventsDuplicateActorsEnd, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("ForUE Events DeleteActorsEnd"), STAT_WakaTimeForUE_EventsDeleteActorsEnd, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("ForUE Events AddLevelToWorld"), STAT_WakaTimeForUE_EventsAddLevelToWorld, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("ForUE Events PostSaveWorld"), STAT_WakaTimeForUE_EventsPostSaveWorld, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("ForUE Events PostPieStarted"), STAT_WakaTimeForUE_EventsPostPieStarted, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("ForUE Events PrePieEnded"), STAT_WakaTimeForUE_EventsPrePieEnded, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("ForUE Events BlueprintPreCompile"), STAT_WakaTimeForUE_EventsBlueprintPreCompile, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("ForUE Heartbeats Queued"), STAT_WakaTimeForUE_HeartbeatsQueued, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("ForUE Heartbeats Sent"), STAT_WakaTimeForUE_HeartbeatsSent, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("ForUE Heartbeats Failed"), STAT_WakaTimeForUE_HeartbeatsFailed, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("ForUE Payload Bytes"), STAT_WakaTimeForUE_PayloadBytes, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("ForUE Http Fallbacks To CLI"), STAT_WakaTimeForUE_HttpFallbacks, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("ForUE Heartbeats Debounced"), STAT_WakaTimeForUE_HeartbeatsDebounced, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("ForUE Frames Over Budget"), STAT_WakaTimeForUE_BudgetOverruns, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("ForUE Heartbeats Deduplicated"), STAT_WakaTimeForUE_HeartbeatsDeduplicated, STATGROUP_Wakatime, );
+DECLARE_FLOAT_ACCUMULATOR_STAT_EXTERN(TEXT("ForUE Dedup Hit Rate (%)"), STAT_WakaTimeForUE_DedupHitRate, STATGROUP_Wakatime, );
+
+// Heartbeat latency histogram (time until wakatime-cli or the HTTP request finished)
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("ForUE Latency < 100 ms"), STAT_WakaTimeForUE_Latency100ms, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("ForUE Latency < 500 ms"), STAT_WakaTimeForUE_Latency500ms, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("ForUE Latency < 2 s"), STAT_WakaTimeForUE_Latency2s, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("ForUE Latency >= 2 s"), STAT_WakaTimeForUE_LatencyOver2s, STATGROUP_Wakatime, );
+
+TRACE_DECLARE_INT_COUNTER_EXTERN(WakaTimeForUE_HeartbeatsQueued);
+TRACE_DECLARE_INT_COUNTER_EXTERN(WakaTimeForUE_HeartbeatsSent);
+TRACE_DECLARE_INT_COUNTER_EXTERN(WakaTimeForUE_HeartbeatsFailed);
+TRACE_DECLARE_MEMORY_COUNTER_EXTERN(WakaTimeForUE_PayloadBytes);
+TRACE_DECLARE_FLOAT_COUNTER_EXTERN(WakaTimeForUE_RequestLatencyMs);
+
+/// <summary>
+///	CPU scope on the plugin's trace channel plus the matching cycle stat
+/// </summary>
+#define WAKATIME_FORUE_SCOPE(Name) \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL_STR("WakaTimeForUE::" #Name, WakaTimeForUEChannel); \
+	SCOPE_CYCLE_COUNTER(STAT_WakaTimeForUE_##Name)
+
+/// <summary>
+///	Bumps a total in both the stat group and the Insights counter track
+/// </summary>
+#define WAKATIME_FORUE_COUNT(Name, Amount) \
+	INC_DWORD_STAT_BY(STAT_WakaTimeForUE_##Name, Amount); \
+	TRACE_COUNTER_ADD(WakaTimeForUE_##Name, Amount)
+
+namespace WakaTimeStats
+{
+	/// <summary>
+	///	Files one finished heartbeat into the latency histogram
+	/// </summary>
+	/// <param name="Seconds"> Time from starting the heartbeat until it completed </param>
+	void RecordRequestLatency(double Seconds);
+}
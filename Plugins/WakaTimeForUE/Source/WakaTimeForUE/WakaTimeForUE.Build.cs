@@ -40,7 +40,11 @@ public class WakaTimeForUE : ModuleRules
 				"EditorStyle",
 				"EngineSettings",
 				"UnrealEd",
-				"Projects"
+				"Projects",
+				"HTTP",
+				"Json",
+				"FileUtilities",
+				"DirectoryWatcher"
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
@@ -0,0 +1,192 @@
+#include "Misc/AutomationTest.h"
+#include "WakatimeActivityStore.h"
+#include "WakatimeHeartbeat.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace WakatimeActivityStoreTests
+{
+	static FWakatimeHeartbeatEvent MakeEvent(const TCHAR* Entity, int64 Time, bool bDebugging = false)
+	{
+		FWakatimeHeartbeatEvent Event;
+		Event.Entity = FName(Entity);
+		Event.Time = Time;
+		Event.bDebugging = bDebugging;
+		return Event;
+	}
+
+	static const FWakatimeStoreTotal* FindTotal(const TArray<FWakatimeStoreTotal>& Totals, const TCHAR* Key)
+	{
+		return Totals.FindByPredicate([Key](const FWakatimeStoreTotal& Total) { return Total.Key == Key; });
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWakatimeActivityStoreRoundTripTest, "WakatimeIntegration.ActivityStore.RoundTrip",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FWakatimeActivityStoreRoundTripTest::RunTest(const FString& Parameters)
+{
+	using namespace WakatimeActivityStoreTests;
+
+	const FString Directory = FPaths::AutomationTransientDir() / TEXT("WakatimeStore");
+	IFileManager::Get().DeleteDirectory(*Directory, false, true);
+
+	const FDateTime Day(2024, 3, 10);
+	const int64 Start = (Day + FTimespan::FromHours(12)).ToUnixTimestamp();
+
+	FWakatimeActivityStore Store;
+	Store.Initialize(Directory);
+	Store.Append(MakeEvent(TEXT("/Game/Maps/Main"), Start));
+	Store.Append(MakeEvent(TEXT("/Game/Maps/Main"), Start + 60));
+	Store.Append(MakeEvent(TEXT("/Game/Props/Crate"), Start + 120));
+	// Past the timeout, so the gap before it counts for nothing
+	Store.Append(MakeEvent(TEXT("/Game/Props/Crate"), Start + 10000));
+	Store.Append(MakeEvent(TEXT("/Game/Maps/Main"), Start + 10030, true));
+	Store.Flush();
+
+	// Decoding has to give back exactly what was encoded: times, interned entities and categories
+	TArray<FWakatimeStoreTotal> Totals;
+	double TotalSeconds = 0.0;
+	TestTrue(TEXT("Query finds the block"), FWakatimeActivityStore::Query(Directory, Day, Day + FTimespan::FromDays(1),
+		EWakatimeStoreGrouping::Entity, Totals, TotalSeconds));
+	TestEqual(TEXT("Total time"), TotalSeconds, 150.0);
+	const FWakatimeStoreTotal* Main = FindTotal(Totals, TEXT("/Game/Maps/Main"));
+	const FWakatimeStoreTotal* Crate = FindTotal(Totals, TEXT("/Game/Props/Crate"));
+	if (TestNotNull(TEXT("Main map"), Main) && TestNotNull(TEXT("Crate"), Crate)) {
+		TestEqual(TEXT("Main map time"), Main->Seconds, 120.0);
+		TestEqual(TEXT("Main map heartbeats"), Main->Heartbeats, 3);
+		TestEqual(TEXT("Crate time"), Crate->Seconds, 30.0);
+		TestEqual(TEXT("Crate heartbeats"), Crate->Heartbeats, 2);
+	}
+
+	FWakatimeActivityStore::Query(Directory, Day, Day + FTimespan::FromDays(1), EWakatimeStoreGrouping::Folder, Totals, TotalSeconds);
+	TestNotNull(TEXT("Folder grouping"), FindTotal(Totals, TEXT("/Game/Props")));
+	FWakatimeActivityStore::Query(Directory, Day, Day + FTimespan::FromDays(1), EWakatimeStoreGrouping::Category, Totals, TotalSeconds);
+	TestNotNull(TEXT("Debugging category"), FindTotal(Totals, TEXT("debugging")));
+
+	TestFalse(TEXT("Nothing outside the range"), FWakatimeActivityStore::Query(Directory, Day - FTimespan::FromDays(1), Day,
+		EWakatimeStoreGrouping::Entity, Totals, TotalSeconds));
+
+	// Buffered rows count once, even the one that was also written out in the meantime
+	Store.Append(MakeEvent(TEXT("/Game/Maps/Main"), Start + 10060));
+	TArray<FWakatimeActivityStore::FRow> Buffered = Store.GetBufferedRows();
+	FWakatimeActivityStore::FRow& Written = Buffered.AddDefaulted_GetRef();
+	Written.Time = Start + 10030;
+	Written.Entity = FName(TEXT("/Game/Maps/Main"));
+	Written.bDebugging = true;
+	FWakatimeActivityStore::Query(Directory, Day, Day + FTimespan::FromDays(1), EWakatimeStoreGrouping::Entity, Buffered, Totals, TotalSeconds);
+	TestEqual(TEXT("Total time with buffered rows"), TotalSeconds, 180.0);
+	Main = FindTotal(Totals, TEXT("/Game/Maps/Main"));
+	if (TestNotNull(TEXT("Main map with buffered rows"), Main)) {
+		TestEqual(TEXT("Buffered row counted once"), Main->Heartbeats, 4);
+	}
+	Store.Shutdown();
+
+	IFileManager::Get().DeleteDirectory(*Directory, false, true);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWakatimeActivityStoreDamageTest, "WakatimeIntegration.ActivityStore.DamagedBlock",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FWakatimeActivityStoreDamageTest::RunTest(const FString& Parameters)
+{
+	using namespace WakatimeActivityStoreTests;
+
+	const FString Directory = FPaths::AutomationTransientDir() / TEXT("WakatimeStoreDamage");
+	IFileManager::Get().DeleteDirectory(*Directory, false, true);
+
+	const FDateTime Day(2024, 3, 10);
+	const int64 Start = (Day + FTimespan::FromHours(12)).ToUnixTimestamp();
+
+	FWakatimeActivityStore Store;
+	Store.Initialize(Directory);
+	Store.Append(MakeEvent(TEXT("/Game/Maps/Main"), Start));
+	Store.Append(MakeEvent(TEXT("/Game/Maps/Main"), Start + 60));
+	Store.Shutdown();
+
+	TArray<FString> Files;
+	IFileManager::Get().FindFiles(Files, *(Directory / TEXT("*")), true, false);
+	if (!TestEqual(TEXT("One month file written"), Files.Num(), 1)) {
+		return false;
+	}
+
+	// Flip a byte of the payload; the block CRC no longer matches and the block is skipped
+	const FString Path = Directory / Files[0];
+	TArray<uint8> Data;
+	FFileHelper::LoadFileToArray(Data, *Path);
+	if (!TestTrue(TEXT("Block has a payload"), Data.Num() > 0)) {
+		return false;
+	}
+	Data.Last() ^= 0xFF;
+	FFileHelper::SaveArrayToFile(Data, *Path);
+
+	AddExpectedError(TEXT("damaged block"), EAutomationExpectedErrorFlags::Contains, 1);
+	TArray<FWakatimeStoreTotal> Totals;
+	double TotalSeconds = 0.0;
+	TestFalse(TEXT("Damaged block yields no data"), FWakatimeActivityStore::Query(Directory, Day, Day + FTimespan::FromDays(1),
+		EWakatimeStoreGrouping::Entity, Totals, TotalSeconds));
+
+	IFileManager::Get().DeleteDirectory(*Directory, false, true);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWakatimeActivityStoreTornBlockTest, "WakatimeIntegration.ActivityStore.TornBlock",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FWakatimeActivityStoreTornBlockTest::RunTest(const FString& Parameters)
+{
+	using namespace WakatimeActivityStoreTests;
+
+	const FString Directory = FPaths::AutomationTransientDir() / TEXT("WakatimeStoreTorn");
+	IFileManager::Get().DeleteDirectory(*Directory, false, true);
+
+	const FDateTime Day(2024, 3, 10);
+	const int64 Start = (Day + FTimespan::FromHours(12)).ToUnixTimestamp();
+
+	FWakatimeActivityStore Store;
+	Store.Initialize(Directory);
+	Store.Append(MakeEvent(TEXT("/Game/Maps/Lost"), Start));
+	Store.Append(MakeEvent(TEXT("/Game/Maps/Lost"), Start + 60));
+	Store.Flush();
+
+	TArray<FString> Files;
+	IFileManager::Get().FindFiles(Files, *(Directory / TEXT("*")), true, false);
+	if (!TestEqual(TEXT("One month file written"), Files.Num(), 1)) {
+		return false;
+	}
+	const FString Path = Directory / Files[0];
+	const int64 FirstBlockBytes = IFileManager::Get().FileSize(*Path);
+
+	Store.Append(MakeEvent(TEXT("/Game/Maps/Kept"), Start + 120));
+	Store.Append(MakeEvent(TEXT("/Game/Maps/Kept"), Start + 180));
+	Store.Shutdown();
+
+	// Cut the tail off the first block's payload, as if the editor died mid-write and the next session
+	// appended after it. The first block's header still claims the full length.
+	TArray<uint8> Data;
+	FFileHelper::LoadFileToArray(Data, *Path);
+	if (!TestTrue(TEXT("First block has a payload to tear"), FirstBlockBytes > 40 + 3)) {
+		return false;
+	}
+	Data.RemoveAt(static_cast<int32>(FirstBlockBytes) - 3, 3);
+	FFileHelper::SaveArrayToFile(Data, *Path);
+
+	AddExpectedError(TEXT("damaged block"), EAutomationExpectedErrorFlags::Contains, 1);
+	TArray<FWakatimeStoreTotal> Totals;
+	double TotalSeconds = 0.0;
+	FWakatimeActivityStore::Query(Directory, Day, Day + FTimespan::FromDays(1), EWakatimeStoreGrouping::Entity, Totals, TotalSeconds);
+	TestNull(TEXT("Torn block is skipped"), FindTotal(Totals, TEXT("/Game/Maps/Lost")));
+	const FWakatimeStoreTotal* Kept = FindTotal(Totals, TEXT("/Game/Maps/Kept"));
+	if (TestNotNull(TEXT("Block after the torn one is read"), Kept)) {
+		TestEqual(TEXT("Block after the torn one is complete"), Kept->Heartbeats, 2);
+	}
+
+	IFileManager::Get().DeleteDirectory(*Directory, false, true);
+	return true;
+}
+
+#endif
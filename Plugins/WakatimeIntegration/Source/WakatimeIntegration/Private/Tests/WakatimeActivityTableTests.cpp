@@ -0,0 +1,90 @@
+#include "Misc/AutomationTest.h"
+#include "WakatimeActivityTable.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+static FName MakeTestPackage(int32 Index)
+{
+	return FName(*FString::Printf(TEXT("/Game/WakatimeTests/Package_%d"), Index));
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWakatimeActivityTableEvictionTest, "WakatimeIntegration.ActivityTable.Eviction",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FWakatimeActivityTableEvictionTest::RunTest(const FString& Parameters)
+{
+	// Few enough entries that the sampled LRU sees all of them and always evicts the oldest, and enough
+	// packages that probe runs wrap around the slot array many times
+	const int32 MaxEntries = 8;
+	const int32 NumPackages = 500;
+	FWakatimeActivityTable Table(MaxEntries);
+
+	for (int32 Index = 0; Index < NumPackages; ++Index)
+	{
+		FWakatimeEntityActivity Evicted;
+		bool bEvicted = false;
+		FWakatimeEntityActivity& Entry = Table.FindOrAdd(MakeTestPackage(Index), Index, Evicted, bEvicted);
+		Entry.Additions = Index + 1;
+
+		if (Index >= MaxEntries) {
+			if (!TestTrue(TEXT("Full table evicts"), bEvicted)
+				|| !TestTrue(TEXT("Oldest entry is evicted"), Evicted.Package == MakeTestPackage(Index - MaxEntries)))
+			{
+				return false;
+			}
+		}
+		else if (!TestFalse(TEXT("Table with room does not evict"), bEvicted)) {
+			return false;
+		}
+		TestEqual(TEXT("Entry count"), Table.Num(), FMath::Min(Index + 1, MaxEntries));
+
+		// After backward-shift deletion every remaining entry must still be reachable from its home slot.
+		// Looking one up again with its own time keeps the LRU order intact.
+		for (int32 Remaining = FMath::Max(Index - MaxEntries + 1, 0); Remaining <= Index; ++Remaining)
+		{
+			bool bLookupEvicted = false;
+			const FWakatimeEntityActivity& Found = Table.FindOrAdd(MakeTestPackage(Remaining), Remaining, Evicted, bLookupEvicted);
+			if (!TestFalse(TEXT("Lookup of a present entry does not evict"), bLookupEvicted)
+				|| !TestEqual(TEXT("Lookup returns the existing entry"), Found.Additions, Remaining + 1))
+			{
+				return false;
+			}
+		}
+	}
+
+	TArray<FWakatimeEntityActivity> Drained;
+	Table.Drain(Drained);
+	TestEqual(TEXT("Drain returns every entry"), Drained.Num(), MaxEntries);
+	TestEqual(TEXT("Drain empties the table"), Table.Num(), 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWakatimeActivityMergeTest, "WakatimeIntegration.ActivityTable.Merge",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FWakatimeActivityMergeTest::RunTest(const FString& Parameters)
+{
+	FWakatimeEntityActivity Aggregate;
+	FWakatimeEntityActivity First;
+	First.Package = MakeTestPackage(1);
+	First.Additions = 2;
+	First.FirstTime = 100;
+	First.LastTime = 150;
+	FWakatimeEntityActivity Second;
+	Second.Package = MakeTestPackage(2);
+	Second.Saves = 1;
+	Second.FirstTime = 50;
+	Second.LastTime = 120;
+	Second.bIsWrite = true;
+
+	Aggregate.Merge(First);
+	Aggregate.Merge(Second);
+	TestTrue(TEXT("Merge leaves the package alone"), Aggregate.IsEmpty());
+	TestEqual(TEXT("Events are summed"), Aggregate.NumEvents(), 3);
+	TestEqual(TEXT("First time is the earliest"), Aggregate.FirstTime, static_cast<int64>(50));
+	TestEqual(TEXT("Last time is the latest"), Aggregate.LastTime, static_cast<int64>(150));
+	TestTrue(TEXT("Any write makes the aggregate a write"), Aggregate.bIsWrite);
+	return true;
+}
+
+#endif
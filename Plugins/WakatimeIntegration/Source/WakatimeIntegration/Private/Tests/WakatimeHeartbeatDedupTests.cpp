@@ -0,0 +1,56 @@
+#include "Misc/AutomationTest.h"
+#include "WakatimeHeartbeatDedup.h"
+#include "WakatimeHeartbeat.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWakatimeHeartbeatDedupTest, "WakatimeIntegration.HeartbeatDedup",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FWakatimeHeartbeatDedupTest::RunTest(const FString& Parameters)
+{
+	FWakatimeHeartbeatDedup Dedup(2);
+
+	FWakatimeHeartbeatEvent Event;
+	Event.Entity = FName(TEXT("/Game/Maps/Main"));
+	Event.Time = 1000;
+	TestTrue(TEXT("First heartbeat"), Dedup.ShouldSend(Event));
+
+	Event.Time = 1060;
+	TestFalse(TEXT("Same entity within two minutes"), Dedup.ShouldSend(Event));
+
+	// The window counts from the last heartbeat that went out, not the last one dropped
+	Event.Time = 1120;
+	TestTrue(TEXT("Two minutes after the last one sent"), Dedup.ShouldSend(Event));
+
+	Event.Time = 1130;
+	Event.bIsWrite = true;
+	TestTrue(TEXT("is_write changed"), Dedup.ShouldSend(Event));
+
+	Event.Time = 1140;
+	Event.Lines = 3;
+	TestTrue(TEXT("Line changes always go through"), Dedup.ShouldSend(Event));
+	Event.Lines = 0;
+
+	Event.bDebugging = true;
+	TestTrue(TEXT("Debugging is its own category"), Dedup.ShouldSend(Event));
+
+	// Earlier than the last one sent, as an evicted table entry can be
+	Event.Time = 1100;
+	TestFalse(TEXT("Window applies both ways"), Dedup.ShouldSend(Event));
+
+	// Capacity is two, so a third entity pushes the least recently used one out
+	FWakatimeHeartbeatEvent Other;
+	Other.Entity = FName(TEXT("/Game/Props/Crate"));
+	Other.Time = 1150;
+	TestTrue(TEXT("Other entity"), Dedup.ShouldSend(Other));
+	Event.bDebugging = false;
+	Event.bIsWrite = true;
+	Event.Time = 1150;
+	TestTrue(TEXT("Evicted entity is sent again"), Dedup.ShouldSend(Event));
+
+	TestEqual(TEXT("Hit rate"), Dedup.GetHitRate(), 2.0 / 9.0);
+	return true;
+}
+
+#endif
@@ -0,0 +1,64 @@
+#include "Misc/AutomationTest.h"
+#include "WakatimeSpool.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWakatimeSpoolRecoveryTest, "WakatimeIntegration.Spool.CrcRecovery",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FWakatimeSpoolRecoveryTest::RunTest(const FString& Parameters)
+{
+	const FString Directory = FPaths::AutomationTransientDir() / TEXT("WakatimeSpool");
+	IFileManager::Get().DeleteDirectory(*Directory, false, true);
+
+	{
+		FWakatimeSpool Spool;
+		Spool.Initialize(Directory, 1024 * 1024);
+		Spool.Append(TArray<FString>{ TEXT("{\"entity\":\"a\"}"), TEXT("{\"entity\":\"b\"}"), TEXT("{\"entity\":\"c\"}") });
+		Spool.Shutdown();
+	}
+
+	TArray<FString> Segments;
+	IFileManager::Get().FindFiles(Segments, *(Directory / TEXT("*.log")), true, false);
+	if (!TestEqual(TEXT("One segment written"), Segments.Num(), 1)) {
+		return false;
+	}
+
+	// Damage the second record's payload and leave a torn record at the end, as a crash mid-write would
+	const FString SegmentPath = Directory / Segments[0];
+	FString Contents;
+	FFileHelper::LoadFileToString(Contents, *SegmentPath);
+	const int32 Damaged = Contents.Find(TEXT("\"b\""));
+	if (!TestTrue(TEXT("Second record found"), Damaged != INDEX_NONE)) {
+		return false;
+	}
+	Contents[Damaged + 1] = TEXT('x');
+	Contents += TEXT("00000000 {\"entity\":\"torn");
+	FFileHelper::SaveStringToFile(Contents, *SegmentPath);
+
+	// The segment belongs to this process, so a fresh spool adopts it
+	TArray<FString> Heartbeats;
+	{
+		FWakatimeSpool Spool;
+		Spool.Initialize(Directory, 1024 * 1024);
+		FString Claimed;
+		TestTrue(TEXT("Spooled segment is pending"), Spool.ClaimSegment(Claimed, Heartbeats));
+		Spool.ReleaseSegment(Claimed);
+		TestFalse(TEXT("Nothing left after release"), Spool.HasPending());
+		Spool.Shutdown();
+	}
+
+	TestEqual(TEXT("Damaged and torn records are skipped"), Heartbeats.Num(), 2);
+	if (Heartbeats.Num() == 2) {
+		TestEqual(TEXT("First record intact"), Heartbeats[0], FString(TEXT("{\"entity\":\"a\"}")));
+		TestEqual(TEXT("Third record intact"), Heartbeats[1], FString(TEXT("{\"entity\":\"c\"}")));
+	}
+
+	IFileManager::Get().DeleteDirectory(*Directory, false, true);
+	return true;
+}
+
+#endif
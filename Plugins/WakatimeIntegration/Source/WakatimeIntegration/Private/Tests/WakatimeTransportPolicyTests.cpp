@@ -0,0 +1,93 @@
+#include "Misc/AutomationTest.h"
+#include "WakatimeRateLimiter.h"
+#include "WakatimeTransportPolicy.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWakatimeTokenBucketTest, "WakatimeIntegration.TransportPolicy.TokenBucket",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FWakatimeTokenBucketTest::RunTest(const FString& Parameters)
+{
+	FWakatimeTokenBucket Bucket;
+	Bucket.Configure(1.0, 3.0);
+
+	TestTrue(TEXT("Burst 1"), Bucket.TryConsume(0.0));
+	TestTrue(TEXT("Burst 2"), Bucket.TryConsume(0.0));
+	TestTrue(TEXT("Burst 3"), Bucket.TryConsume(0.0));
+	TestFalse(TEXT("Burst exhausted"), Bucket.TryConsume(0.0));
+	TestFalse(TEXT("Half a token is not enough"), Bucket.TryConsume(0.5));
+	TestTrue(TEXT("Refilled after a second"), Bucket.TryConsume(1.0));
+	TestFalse(TEXT("Refill was used up"), Bucket.TryConsume(1.0));
+
+	// A long pause refills up to the capacity and no further
+	int32 Admitted = 0;
+	while (Bucket.TryConsume(100.0))
+	{
+		++Admitted;
+	}
+	TestEqual(TEXT("Refill is capped at the capacity"), Admitted, 3);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWakatimeBackoffTest, "WakatimeIntegration.TransportPolicy.Backoff",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FWakatimeBackoffTest::RunTest(const FString& Parameters)
+{
+	FWakatimeBackoff Backoff;
+	Backoff.Configure(2.0, 10.0);
+
+	const double Ceilings[] = { 2.0, 4.0, 8.0, 10.0, 10.0, 10.0 };
+	for (double Ceiling : Ceilings)
+	{
+		const double Delay = Backoff.NextDelay(0.0);
+		if (!TestTrue(FString::Printf(TEXT("Delay %f within [0, %f]"), Delay, Ceiling), Delay >= 0.0 && Delay <= Ceiling)) {
+			return false;
+		}
+	}
+
+	TestTrue(TEXT("Retry-After is a lower bound"), Backoff.NextDelay(30.0) >= 30.0);
+
+	for (int32 Sample = 0; Sample < 100; ++Sample)
+	{
+		Backoff.Reset();
+		if (!TestTrue(TEXT("Reset starts from the base delay"), Backoff.NextDelay(0.0) <= 2.0)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWakatimeCircuitBreakerTest, "WakatimeIntegration.TransportPolicy.CircuitBreaker",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FWakatimeCircuitBreakerTest::RunTest(const FString& Parameters)
+{
+	FWakatimeCircuitBreaker Breaker;
+	Breaker.Configure(3, 10.0, 40.0);
+
+	Breaker.RecordFailure(0.0);
+	Breaker.RecordFailure(0.0);
+	TestTrue(TEXT("Below the threshold the circuit stays closed"), Breaker.TryAcquire(0.0));
+	Breaker.RecordFailure(0.0);
+	TestTrue(TEXT("Threshold opens the circuit"), Breaker.IsOpen(0.0));
+	TestFalse(TEXT("Open circuit rejects"), Breaker.TryAcquire(5.0));
+
+	TestTrue(TEXT("Cooldown over lets a probe through"), Breaker.TryAcquire(10.0));
+	TestTrue(TEXT("Probe makes it half open"), Breaker.State == EWakatimeCircuitState::HalfOpen);
+	TestFalse(TEXT("Only one probe at a time"), Breaker.TryAcquire(10.0));
+
+	// A failed probe reopens the circuit with twice the cooldown
+	Breaker.RecordFailure(10.0);
+	TestFalse(TEXT("Failed probe reopens"), Breaker.TryAcquire(29.0));
+	TestTrue(TEXT("Doubled cooldown over"), Breaker.TryAcquire(30.0));
+
+	Breaker.RecordSuccess();
+	TestTrue(TEXT("Successful probe closes"), Breaker.State == EWakatimeCircuitState::Closed);
+	TestTrue(TEXT("Closed circuit lets requests through"), Breaker.TryAcquire(30.0));
+	TestEqual(TEXT("Success resets the cooldown"), Breaker.Cooldown, 10.0);
+	return true;
+}
+
+#endif
@@ -0,0 +1,506 @@
+#include "WakatimeActivityStore.h"
+#include "WakatimeHeartbeat.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Crc.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+
+namespace WakatimeStore
+{
+	static const uint32 BlockMagic = 0x424B5457; // 'WTKB'
+	static const uint16 BlockVersion = 1;
+
+	// A block is written once this many rows are buffered or the oldest of them is this old
+	static const int32 MaxBufferedRows = 256;
+	static const double MaxBufferedSeconds = 15.0 * 60.0;
+
+	static const TCHAR* CodingCategory = TEXT("coding");
+	static const TCHAR* DebuggingCategory = TEXT("debugging");
+
+	/** Fixed-size part of a block; everything after it is the varint payload. */
+	struct FBlockHeader
+	{
+		uint32 Magic;
+		uint16 Version;
+		uint16 Flags;
+		uint32 RowCount;
+		uint32 PayloadBytes;
+		uint32 PayloadCrc;
+		uint32 Reserved;
+		int64 MinTime;
+		int64 MaxTime;
+	};
+	static_assert(sizeof(FBlockHeader) == 40, "The block header is part of the file format");
+
+	static FString MakeFilePath(const FString& Directory, int32 Year, int32 Month)
+	{
+		return Directory / FString::Printf(TEXT("activity-%04d%02d.wkc"), Year, Month);
+	}
+
+	static void WriteVarint(TArray<uint8>& Out, uint64 Value)
+	{
+		while (Value >= 0x80) {
+			Out.Add(static_cast<uint8>(Value) | 0x80);
+			Value >>= 7;
+		}
+		Out.Add(static_cast<uint8>(Value));
+	}
+
+	static bool ReadVarint(const uint8*& Cursor, const uint8* End, uint64& OutValue)
+	{
+		OutValue = 0;
+		for (int32 Shift = 0; Shift < 64 && Cursor < End; Shift += 7)
+		{
+			const uint8 Byte = *Cursor++;
+			OutValue |= static_cast<uint64>(Byte & 0x7F) << Shift;
+			if ((Byte & 0x80) == 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static uint64 ZigZag(int64 Value)
+	{
+		return (static_cast<uint64>(Value) << 1) ^ static_cast<uint64>(Value >> 63);
+	}
+
+	static int64 UnZigZag(uint64 Value)
+	{
+		return static_cast<int64>(Value >> 1) ^ -static_cast<int64>(Value & 1);
+	}
+
+	/** Rows of every block in range, with strings interned across blocks. */
+	struct FDecodedRows
+	{
+		TArray<int64> Times;
+		TArray<int32> Entities;
+		TArray<int32> Categories;
+		TArray<FString> Strings;
+		TMap<FString, int32> StringIds;
+		int32 Damaged = 0;
+
+		int32 Intern(FString&& String)
+		{
+			if (const int32* Existing = StringIds.Find(String)) {
+				return *Existing;
+			}
+			const int32 Id = Strings.Num();
+			StringIds.Add(String, Id);
+			Strings.Add(MoveTemp(String));
+			return Id;
+		}
+	};
+
+	static bool DecodeBlock(const FBlockHeader& Header, const uint8* Payload, int64 FromTime, int64 ToTime, FDecodedRows& Out)
+	{
+		const uint8* Cursor = Payload;
+		const uint8* End = Payload + Header.PayloadBytes;
+		const int32 RowCount = static_cast<int32>(Header.RowCount);
+
+		// Every row takes at least a byte in each of its three columns
+		if (static_cast<uint64>(RowCount) * 3 > Header.PayloadBytes) {
+			return false;
+		}
+
+		uint64 StringCount = 0;
+		if (!ReadVarint(Cursor, End, StringCount) || StringCount > Header.PayloadBytes) {
+			return false;
+		}
+		TArray<int32, TInlineAllocator<64>> LocalToGlobal;
+		LocalToGlobal.Reserve(static_cast<int32>(StringCount));
+		for (uint64 Index = 0; Index < StringCount; ++Index)
+		{
+			uint64 Length = 0;
+			if (!ReadVarint(Cursor, End, Length) || Length > static_cast<uint64>(End - Cursor)) {
+				return false;
+			}
+			FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(Cursor), static_cast<int32>(Length));
+			LocalToGlobal.Add(Out.Intern(FString(Converted.Length(), Converted.Get())));
+			Cursor += Length;
+		}
+
+		// Columns are stored one after the other; decode the times first, then pick rows in range
+		TArray<int64> Times;
+		Times.SetNumUninitialized(RowCount);
+		int64 Time = Header.MinTime;
+		for (int32 Row = 0; Row < RowCount; ++Row)
+		{
+			uint64 Delta = 0;
+			if (!ReadVarint(Cursor, End, Delta)) {
+				return false;
+			}
+			Time += UnZigZag(Delta);
+			Times[Row] = Time;
+		}
+
+		const int32 FirstOut = Out.Times.Num();
+		TArray<int32> Entities;
+		Entities.SetNumUninitialized(RowCount);
+		for (int32 Column = 0; Column < 2; ++Column)
+		{
+			for (int32 Row = 0; Row < RowCount; ++Row)
+			{
+				uint64 Id = 0;
+				if (!ReadVarint(Cursor, End, Id) || Id >= StringCount) {
+					Out.Times.SetNum(FirstOut);
+					Out.Entities.SetNum(FirstOut);
+					Out.Categories.SetNum(FirstOut);
+					return false;
+				}
+				if (Column == 0) {
+					Entities[Row] = LocalToGlobal[static_cast<int32>(Id)];
+				}
+				else if (Times[Row] >= FromTime && Times[Row] < ToTime) {
+					Out.Times.Add(Times[Row]);
+					Out.Entities.Add(Entities[Row]);
+					Out.Categories.Add(LocalToGlobal[static_cast<int32>(Id)]);
+				}
+			}
+		}
+		return true;
+	}
+
+	static void ReadFile(const FString& Path, int64 FromTime, int64 ToTime, FDecodedRows& Out)
+	{
+		TArray<uint8> Data;
+		if (!FFileHelper::LoadFileToArray(Data, *Path, FILEREAD_Silent)) {
+			return;
+		}
+
+		const int64 HeaderBytes = sizeof(FBlockHeader);
+
+		// Torn write, or two editors appended at once. Nothing in a damaged block can be trusted, its
+		// PayloadBytes included, and a write torn inside the header leaves the next block starting
+		// within it; so the search for the next magic starts one byte in
+		auto NextMagic = [&Data, HeaderBytes](int64 From)
+		{
+			while (From + HeaderBytes <= Data.Num() && FMemory::Memcmp(Data.GetData() + From, &BlockMagic, sizeof(BlockMagic)) != 0)
+			{
+				++From;
+			}
+			return From;
+		};
+
+		int64 Offset = 0;
+		while (Offset + HeaderBytes <= Data.Num())
+		{
+			FBlockHeader Header;
+			FMemory::Memcpy(&Header, Data.GetData() + Offset, HeaderBytes);
+			const uint8* Payload = Data.GetData() + Offset + HeaderBytes;
+			const int64 BlockEnd = Offset + HeaderBytes + Header.PayloadBytes;
+
+			// The CRC is checked even for blocks outside the range: skipping one means trusting its length
+			if (Header.Magic != BlockMagic || Header.Version != BlockVersion || BlockEnd > Data.Num()
+				|| FCrc::MemCrc32(Payload, Header.PayloadBytes) != Header.PayloadCrc)
+			{
+				++Out.Damaged;
+				Offset = NextMagic(Offset + 1);
+				continue;
+			}
+
+			if (Header.MaxTime >= FromTime && Header.MinTime < ToTime && !DecodeBlock(Header, Payload, FromTime, ToTime, Out)) {
+				++Out.Damaged;
+				Offset = NextMagic(Offset + 1);
+				continue;
+			}
+			Offset = BlockEnd;
+		}
+	}
+}
+
+FString FWakatimeActivityStore::GetDefaultDirectory()
+{
+	return FPaths::ProjectSavedDir() / TEXT("Wakatime") / TEXT("Store");
+}
+
+FDateTime FWakatimeActivityStore::GetLocalDayStart(int32 DaysAgo)
+{
+	const FDateTime LocalNow = FDateTime::Now();
+	const FTimespan UtcOffset = LocalNow - FDateTime::UtcNow();
+	return LocalNow.GetDate() - UtcOffset - FTimespan::FromDays(DaysAgo);
+}
+
+void FWakatimeActivityStore::Initialize(const FString& InDirectory)
+{
+	Directory = InDirectory;
+	IFileManager::Get().MakeDirectory(*Directory, true);
+	Rows.Reset();
+}
+
+void FWakatimeActivityStore::Shutdown()
+{
+	Flush();
+	Directory.Reset();
+}
+
+void FWakatimeActivityStore::Append(const FWakatimeHeartbeatEvent& Event)
+{
+	if (Directory.IsEmpty()) {
+		return;
+	}
+	if (Rows.Num() == 0) {
+		OldestRowTime = FPlatformTime::Seconds();
+	}
+	FRow& Row = Rows.AddDefaulted_GetRef();
+	Row.Time = Event.Time;
+	Row.Entity = Event.Entity;
+	Row.bDebugging = Event.bDebugging;
+
+	if (Rows.Num() >= WakatimeStore::MaxBufferedRows) {
+		Flush();
+	}
+}
+
+void FWakatimeActivityStore::Tick()
+{
+	if (Rows.Num() > 0 && FPlatformTime::Seconds() - OldestRowTime >= WakatimeStore::MaxBufferedSeconds) {
+		Flush();
+	}
+}
+
+void FWakatimeActivityStore::Flush()
+{
+	using namespace WakatimeStore;
+
+	if (Rows.Num() == 0 || Directory.IsEmpty()) {
+		return;
+	}
+
+	// Rows are almost always in order already; sorting keeps the deltas small when they are not
+	Rows.StableSort([](const FRow& A, const FRow& B) { return A.Time < B.Time; });
+
+	int32 First = 0;
+	while (First < Rows.Num())
+	{
+		// One block per month file the rows fall into
+		const FDateTime FirstDate = FDateTime::FromUnixTimestamp(Rows[First].Time);
+		int32 Last = First + 1;
+		while (Last < Rows.Num())
+		{
+			const FDateTime Date = FDateTime::FromUnixTimestamp(Rows[Last].Time);
+			if (Date.GetYear() != FirstDate.GetYear() || Date.GetMonth() != FirstDate.GetMonth()) {
+				break;
+			}
+			++Last;
+		}
+
+		TMap<FName, int32> EntityIds;
+		TArray<uint8> Strings;
+		int32 StringCount = 0;
+		auto AddString = [&Strings, &StringCount](const FString& String)
+		{
+			FTCHARToUTF8 Utf8(*String);
+			WriteVarint(Strings, Utf8.Length());
+			Strings.Append(reinterpret_cast<const uint8*>(Utf8.Get()), Utf8.Length());
+			return StringCount++;
+		};
+		const int32 CodingId = AddString(CodingCategory);
+		const int32 DebuggingId = AddString(DebuggingCategory);
+
+		TArray<uint8> TimeColumn;
+		TArray<uint8> EntityColumn;
+		TArray<uint8> CategoryColumn;
+		int64 Previous = Rows[First].Time;
+		for (int32 Index = First; Index < Last; ++Index)
+		{
+			const FRow& Row = Rows[Index];
+			int32* EntityId = EntityIds.Find(Row.Entity);
+			if (!EntityId) {
+				EntityId = &EntityIds.Add(Row.Entity, AddString(Row.Entity.ToString()));
+			}
+			WriteVarint(TimeColumn, ZigZag(Row.Time - Previous));
+			WriteVarint(EntityColumn, *EntityId);
+			WriteVarint(CategoryColumn, Row.bDebugging ? DebuggingId : CodingId);
+			Previous = Row.Time;
+		}
+
+		TArray<uint8> Block;
+		Block.SetNumZeroed(sizeof(FBlockHeader));
+		WriteVarint(Block, StringCount);
+		Block.Append(Strings);
+		Block.Append(TimeColumn);
+		Block.Append(EntityColumn);
+		Block.Append(CategoryColumn);
+
+		FBlockHeader Header;
+		Header.Magic = BlockMagic;
+		Header.Version = BlockVersion;
+		Header.Flags = 0;
+		Header.RowCount = Last - First;
+		Header.PayloadBytes = Block.Num() - sizeof(FBlockHeader);
+		Header.PayloadCrc = FCrc::MemCrc32(Block.GetData() + sizeof(FBlockHeader), Header.PayloadBytes);
+		Header.Reserved = 0;
+		Header.MinTime = Rows[First].Time;
+		Header.MaxTime = Rows[Last - 1].Time;
+		FMemory::Memcpy(Block.GetData(), &Header, sizeof(FBlockHeader));
+
+		// The whole block goes out in one write so a crash leaves at most one torn block behind
+		const FString Path = MakeFilePath(Directory, FirstDate.GetYear(), FirstDate.GetMonth());
+		TUniquePtr<IFileHandle> Handle(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*Path, true));
+		if (!Handle || !Handle->Write(Block.GetData(), Block.Num())) {
+			UE_LOG(LogTemp, Warning, TEXT("Wakatime Integration: Could not write %d row(s) to the activity store at %s"), Last - First, *Path);
+		}
+		First = Last;
+	}
+	Rows.Reset();
+}
+
+bool FWakatimeActivityStore::Query(const FString& Directory, const FDateTime& From, const FDateTime& To, EWakatimeStoreGrouping Grouping,
+	TArray<FWakatimeStoreTotal>& OutTotals, double& OutTotalSeconds, int64 TimeoutSeconds)
+{
+	return Query(Directory, From, To, Grouping, TArray<FRow>(), OutTotals, OutTotalSeconds, TimeoutSeconds);
+}
+
+bool FWakatimeActivityStore::Query(const FString& Directory, const FDateTime& From, const FDateTime& To, EWakatimeStoreGrouping Grouping,
+	const TArray<FRow>& BufferedRows, TArray<FWakatimeStoreTotal>& OutTotals, double& OutTotalSeconds, int64 TimeoutSeconds)
+{
+	OutTotals.Reset();
+	OutTotalSeconds = 0.0;
+	if (To <= From) {
+		return false;
+	}
+
+	const int64 FromTime = From.ToUnixTimestamp();
+	const int64 ToTime = To.ToUnixTimestamp();
+	WakatimeStore::FDecodedRows Decoded;
+	for (FDateTime Month(From.GetYear(), From.GetMonth(), 1); Month < To; Month += FTimespan::FromDays(FDateTime::DaysInMonth(Month.GetYear(), Month.GetMonth())))
+	{
+		WakatimeStore::ReadFile(WakatimeStore::MakeFilePath(Directory, Month.GetYear(), Month.GetMonth()), FromTime, ToTime, Decoded);
+	}
+	if (Decoded.Damaged > 0) {
+		UE_LOG(LogTemp, Warning, TEXT("Wakatime Integration: Skipped %d damaged block(s) in the activity store"), Decoded.Damaged);
+	}
+
+	if (BufferedRows.Num() > 0) {
+		// The buffer may have been written out while the files were read; rows already decoded from
+		// them (same time, entity and category) are not added a second time
+		int64 BufferedFrom = TNumericLimits<int64>::Max();
+		for (const FRow& Row : BufferedRows)
+		{
+			BufferedFrom = FMath::Min(BufferedFrom, Row.Time);
+		}
+		TSet<TTuple<int64, int32, int32>> Written;
+		for (int32 Index = 0; Index < Decoded.Times.Num(); ++Index)
+		{
+			if (Decoded.Times[Index] >= BufferedFrom) {
+				Written.Add(MakeTuple(Decoded.Times[Index], Decoded.Entities[Index], Decoded.Categories[Index]));
+			}
+		}
+
+		const int32 CodingId = Decoded.Intern(WakatimeStore::CodingCategory);
+		const int32 DebuggingId = Decoded.Intern(WakatimeStore::DebuggingCategory);
+		for (const FRow& Row : BufferedRows)
+		{
+			if (Row.Time < FromTime || Row.Time >= ToTime) {
+				continue;
+			}
+			const int32 Entity = Decoded.Intern(Row.Entity.ToString());
+			const int32 Category = Row.bDebugging ? DebuggingId : CodingId;
+			if (Written.Contains(MakeTuple(Row.Time, Entity, Category))) {
+				continue;
+			}
+			Decoded.Times.Add(Row.Time);
+			Decoded.Entities.Add(Entity);
+			Decoded.Categories.Add(Category);
+		}
+	}
+	if (Decoded.Times.Num() == 0) {
+		return false;
+	}
+
+	// Several editors may have written interleaved blocks; time is counted on the merged timeline
+	TArray<int32> Order;
+	Order.SetNumUninitialized(Decoded.Times.Num());
+	for (int32 Index = 0; Index < Order.Num(); ++Index)
+	{
+		Order[Index] = Index;
+	}
+	Order.Sort([&Decoded](int32 A, int32 B) { return Decoded.Times[A] < Decoded.Times[B]; });
+
+	// Group keys are string IDs; folders are interned on first use
+	TArray<int32> FolderOf;
+	FolderOf.Init(INDEX_NONE, Decoded.Strings.Num());
+	auto GroupOf = [&](int32 Row)
+	{
+		if (Grouping == EWakatimeStoreGrouping::Category) {
+			return Decoded.Categories[Row];
+		}
+		const int32 Entity = Decoded.Entities[Row];
+		if (Grouping == EWakatimeStoreGrouping::Entity) {
+			return Entity;
+		}
+		if (FolderOf[Entity] == INDEX_NONE) {
+			const FString& Package = Decoded.Strings[Entity];
+			FolderOf[Entity] = Decoded.Intern(Package.StartsWith(TEXT("/")) ? FPackageName::GetLongPackagePath(Package) : FString(Package));
+		}
+		return FolderOf[Entity];
+	};
+
+	TMap<int32, FWakatimeStoreTotal> Groups;
+	for (int32 Position = 0; Position < Order.Num(); ++Position)
+	{
+		const int32 Row = Order[Position];
+		int64 Gap = Position + 1 < Order.Num() ? Decoded.Times[Order[Position + 1]] - Decoded.Times[Row] : 0;
+		if (Gap > TimeoutSeconds) {
+			Gap = 0;
+		}
+
+		FWakatimeStoreTotal& Total = Groups.FindOrAdd(GroupOf(Row));
+		Total.Seconds += Gap;
+		++Total.Heartbeats;
+		OutTotalSeconds += Gap;
+	}
+
+	OutTotals.Reserve(Groups.Num());
+	for (TPair<int32, FWakatimeStoreTotal>& Group : Groups)
+	{
+		Group.Value.Key = Decoded.Strings[Group.Key];
+		OutTotals.Add(MoveTemp(Group.Value));
+	}
+	OutTotals.Sort([](const FWakatimeStoreTotal& A, const FWakatimeStoreTotal& B)
+	{
+		return A.Seconds != B.Seconds ? A.Seconds > B.Seconds : A.Key < B.Key;
+	});
+	return true;
+}
+
+bool FWakatimeActivityStore::ParseGrouping(const FString& Text, EWakatimeStoreGrouping& OutGrouping)
+{
+	if (Text == TEXT("asset") || Text == TEXT("entity")) {
+		OutGrouping = EWakatimeStoreGrouping::Entity;
+	}
+	else if (Text == TEXT("folder")) {
+		OutGrouping = EWakatimeStoreGrouping::Folder;
+	}
+	else if (Text == TEXT("category")) {
+		OutGrouping = EWakatimeStoreGrouping::Category;
+	}
+	else {
+		return false;
+	}
+	return true;
+}
+
+void FWakatimeActivityStore::LogReport(const TArray<FWakatimeStoreTotal>& Totals, double TotalSeconds, int32 Top)
+{
+	auto Format = [](double Seconds)
+	{
+		const int32 Minutes = FMath::FloorToInt32(Seconds / 60.0);
+		return FString::Printf(TEXT("%4d:%02d"), Minutes / 60, Minutes % 60);
+	};
+
+	const int32 Shown = Top > 0 ? FMath::Min(Top, Totals.Num()) : Totals.Num();
+	for (int32 Index = 0; Index < Shown; ++Index)
+	{
+		UE_LOG(LogTemp, Display, TEXT("  %s  %6d  %s"), *Format(Totals[Index].Seconds), Totals[Index].Heartbeats, *Totals[Index].Key);
+	}
+	if (Shown < Totals.Num()) {
+		UE_LOG(LogTemp, Display, TEXT("  ... %d more"), Totals.Num() - Shown);
+	}
+	UE_LOG(LogTemp, Display, TEXT("  %s  total"), *Format(TotalSeconds));
+}
@@ -0,0 +1,126 @@
+#include "WakatimeActivityTable.h"
+
+// Number of occupied slots inspected when choosing an entry to evict
+static const int32 EvictionSampleSize = 8;
+
+FWakatimeActivityTable::FWakatimeActivityTable(int32 InMaxEntries)
+{
+	MaxEntries = FMath::Max(InMaxEntries, 1);
+	const uint32 Capacity = FMath::RoundUpToPowerOfTwo(static_cast<uint32>(MaxEntries) * 2);
+	Slots.SetNum(Capacity);
+	Mask = Capacity - 1;
+	HashShift = 32 - FMath::FloorLog2(Capacity);
+}
+
+uint32 FWakatimeActivityTable::HomeSlot(FName Package) const
+{
+	// FName hashes are name table indices, which cluster. Fibonacci hashing: the multiply mixes every
+	// input bit into the high bits of the product, so the slot is taken from the top, not masked off the bottom
+	return (GetTypeHash(Package) * 2654435769u) >> HashShift;
+}
+
+FWakatimeEntityActivity& FWakatimeActivityTable::FindOrAdd(FName Package, int64 Now, FWakatimeEntityActivity& OutEvicted, bool& bOutEvicted)
+{
+	bOutEvicted = false;
+	if (CachedSlot != INDEX_NONE && CachedPackage == Package) {
+		FWakatimeEntityActivity& Entry = Slots[CachedSlot];
+		Entry.LastTime = Now;
+		return Entry;
+	}
+
+	uint32 Slot = HomeSlot(Package);
+	while (!Slots[Slot].IsEmpty())
+	{
+		if (Slots[Slot].Package == Package) {
+			CachedPackage = Package;
+			CachedSlot = Slot;
+			Slots[Slot].LastTime = Now;
+			return Slots[Slot];
+		}
+		Slot = (Slot + 1) & Mask;
+	}
+
+	if (Count >= MaxEntries) {
+		const int32 Victim = PickEvictionSlot();
+		OutEvicted = MoveTemp(Slots[Victim]);
+		bOutEvicted = true;
+		RemoveSlot(Victim);
+
+		// Removal shifts entries back, so the probe has to start over
+		Slot = HomeSlot(Package);
+		while (!Slots[Slot].IsEmpty())
+		{
+			Slot = (Slot + 1) & Mask;
+		}
+	}
+
+	FWakatimeEntityActivity& Entry = Slots[Slot];
+	Entry.Package = Package;
+	Entry.FirstTime = Now;
+	Entry.LastTime = Now;
+	++Count;
+
+	CachedPackage = Package;
+	CachedSlot = Slot;
+	return Entry;
+}
+
+void FWakatimeActivityTable::Drain(TArray<FWakatimeEntityActivity>& OutEntries)
+{
+	OutEntries.Reserve(OutEntries.Num() + Count);
+	for (FWakatimeEntityActivity& Entry : Slots)
+	{
+		if (!Entry.IsEmpty()) {
+			OutEntries.Add(MoveTemp(Entry));
+			Entry = FWakatimeEntityActivity();
+		}
+	}
+	Count = 0;
+	CachedSlot = INDEX_NONE;
+	CachedPackage = NAME_None;
+}
+
+int32 FWakatimeActivityTable::PickEvictionSlot()
+{
+	// Sampled LRU: look at the next few occupied slots after a rolling cursor and take the stalest.
+	// Exact LRU would need a list threaded through the table; during a mass import this is close enough.
+	int32 Best = INDEX_NONE;
+	int32 Sampled = 0;
+	for (uint32 Step = 0; Step <= Mask && Sampled < EvictionSampleSize; ++Step)
+	{
+		const int32 Slot = (EvictionCursor + Step) & Mask;
+		if (Slots[Slot].IsEmpty()) {
+			continue;
+		}
+		if (Best == INDEX_NONE || Slots[Slot].LastTime < Slots[Best].LastTime) {
+			Best = Slot;
+		}
+		++Sampled;
+	}
+	EvictionCursor = (Best + 1) & Mask;
+	return Best;
+}
+
+void FWakatimeActivityTable::RemoveSlot(int32 Slot)
+{
+	// Backward-shift deletion keeps probe sequences intact without tombstones
+	Slots[Slot] = FWakatimeEntityActivity();
+	--Count;
+	CachedSlot = INDEX_NONE;
+	CachedPackage = NAME_None;
+
+	uint32 Hole = Slot;
+	uint32 Next = (Hole + 1) & Mask;
+	while (!Slots[Next].IsEmpty())
+	{
+		const uint32 Home = HomeSlot(Slots[Next].Package);
+		// The entry can fill the hole unless its home slot lies cyclically within (Hole, Next]
+		const bool bHomeBetween = (Hole <= Next) ? (Hole < Home && Home <= Next) : (Hole < Home || Home <= Next);
+		if (!bHomeBetween) {
+			Slots[Hole] = MoveTemp(Slots[Next]);
+			Slots[Next] = FWakatimeEntityActivity();
+			Hole = Next;
+		}
+		Next = (Next + 1) & Mask;
+	}
+}
@@ -0,0 +1,328 @@
+#include "WakatimeBenchmarkCommandlet.h"
+#include "WakatimeIntegration.h"
+#include "WakatimeSettings.h"
+#include "WakatimeStandInServer.h"
+#include "HttpServerConstants.h"
+#include "AssetRegistry/AssetData.h"
+#include "UObject/Package.h"
+#include "Modules/ModuleManager.h"
+#include "Interfaces/IPluginManager.h"
+#include "HttpModule.h"
+#include "HttpManager.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/DateTime.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+
+namespace WakatimeBenchmark
+{
+	static FString EntityName(int32 Index)
+	{
+		return FString::Printf(TEXT("/Game/WakatimeBenchmark/Asset_%d"), Index);
+	}
+
+	static TSharedRef<FJsonObject> MakeDistribution(TArray<double> Samples)
+	{
+		TSharedRef<FJsonObject> Result = MakeShared<FJsonObject>();
+		Result->SetNumberField(TEXT("count"), Samples.Num());
+		if (Samples.Num() == 0) {
+			return Result;
+		}
+
+		Samples.Sort();
+		double Sum = 0.0;
+		for (double Sample : Samples)
+		{
+			Sum += Sample;
+		}
+		auto Percentile = [&Samples](double P)
+		{
+			return Samples[FMath::Clamp(FMath::CeilToInt32(P * Samples.Num()) - 1, 0, Samples.Num() - 1)];
+		};
+
+		Result->SetNumberField(TEXT("mean"), Sum / Samples.Num());
+		Result->SetNumberField(TEXT("p50"), Percentile(0.50));
+		Result->SetNumberField(TEXT("p95"), Percentile(0.95));
+		Result->SetNumberField(TEXT("p99"), Percentile(0.99));
+		Result->SetNumberField(TEXT("max"), Samples.Last());
+		return Result;
+	}
+}
+
+UWakatimeBenchmarkCommandlet::UWakatimeBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UWakatimeBenchmarkCommandlet::Main(const FString& Params)
+{
+	int32 Events = 2000;
+	float EventRate = 200.0f;
+	int32 Port = 8731;
+	float DrainTimeout = 120.0f;
+	float RequestTimeout = 10.0f;
+	FWakatimeStandInFaults Faults;
+	FString OutputPath = FPaths::ProjectSavedDir() / TEXT("Wakatime") / TEXT("Benchmark")
+		/ FString::Printf(TEXT("Benchmark-%s.json"), *FDateTime::UtcNow().ToString());
+
+	FParse::Value(*Params, TEXT("Events="), Events);
+	FParse::Value(*Params, TEXT("Rate="), EventRate);
+	FParse::Value(*Params, TEXT("Port="), Port);
+	FParse::Value(*Params, TEXT("DrainTimeout="), DrainTimeout);
+	FParse::Value(*Params, TEXT("RequestTimeout="), RequestTimeout);
+	FParse::Value(*Params, TEXT("LatencyMs="), Faults.LatencyMs);
+	FParse::Value(*Params, TEXT("Rate401="), Faults.Rate401);
+	FParse::Value(*Params, TEXT("Rate429="), Faults.Rate429);
+	FParse::Value(*Params, TEXT("Rate500="), Faults.Rate500);
+	FParse::Value(*Params, TEXT("DropRate="), Faults.DropRate);
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	Events = FMath::Max(Events, 1);
+	EventRate = FMath::Max(EventRate, 1.0f);
+
+	FWakatimeStandInServer Server;
+	if (!Server.Start(Port, Faults)) {
+		return 1;
+	}
+
+	FWakatimeIntegrationModule& Module = FModuleManager::LoadModuleChecked<FWakatimeIntegrationModule>(TEXT("WakatimeIntegration"));
+	UWakatimeSettings* Settings = GetMutableDefault<UWakatimeSettings>();
+
+	// Point the plugin at the stand-in for the duration of the run. The uploader gets its own spool so
+	// heartbeats from earlier real sessions are neither sent to the stand-in nor mixed with benchmark ones.
+	const FString SavedEndpoint = Settings->WakatimeEndpoint;
+	const FString SavedToken = Settings->WakatimeBearerToken;
+	const float SavedTimeout = FHttpModule::Get().GetHttpTotalTimeout();
+	const int32 SavedMaxHeartbeats = Settings->WakatimeMaxHeartbeatsPerFlush;
+	const FString BenchmarkSpool = FPaths::ProjectSavedDir() / TEXT("Wakatime") / TEXT("BenchmarkSpool");
+	IFileManager::Get().DeleteDirectory(*BenchmarkSpool, false, true);
+
+	Module.Uploader.Shutdown();
+	Settings->WakatimeEndpoint = Server.GetEndpoint();
+	Settings->WakatimeBearerToken = TEXT("benchmark");
+	// Delivery is measured per entity, so nothing may be folded into an aggregate heartbeat
+	Settings->WakatimeMaxHeartbeatsPerFlush = Events + 1;
+	FHttpModule::Get().SetHttpTotalTimeout(RequestTimeout);
+	Module.Uploader.Initialize(BenchmarkSpool);
+
+	UE_LOG(LogTemp, Display, TEXT("Wakatime Integration: Benchmark sending %d events at %.0f/s to %s"), Events, EventRate, *Server.GetEndpoint());
+
+	// The uploader holds on to heartbeats a refused token was sent with until the token setting changes,
+	// which is what a user fixing their key does. Injected 401s are random, so every one renews the token.
+	int32 Refused401 = 0;
+	int32 TokenRenewals = 0;
+	auto RenewRefusedToken = [&Server, Settings, &Refused401, &TokenRenewals]()
+	{
+		const int32 Refused = Server.ResponseCodes.FindRef(static_cast<int32>(EHttpServerResponseCodes::Denied));
+		if (Refused == Refused401) {
+			return;
+		}
+		Refused401 = Refused;
+		Settings->WakatimeBearerToken = FString::Printf(TEXT("benchmark-%d"), ++TokenRenewals);
+#if WITH_EDITOR
+		FPropertyChangedEvent ChangedEvent(UWakatimeSettings::StaticClass()->FindPropertyByName(GET_MEMBER_NAME_CHECKED(UWakatimeSettings, WakatimeBearerToken)));
+		Settings->PostEditChangeProperty(ChangedEvent);
+#endif
+	};
+
+	TMap<FString, double> InjectTimes;
+	InjectTimes.Reserve(Events);
+	TArray<double> GameThreadMicros;
+	GameThreadMicros.Reserve(Events);
+
+	// Inject phase: events arrive at the requested rate while the engine keeps ticking
+	const double Start = FPlatformTime::Seconds();
+	double LastTick = Start;
+	double LastHeartbeat = Start;
+	int32 Injected = 0;
+	while (Injected < Events)
+	{
+		const double Now = FPlatformTime::Seconds();
+		const int32 Due = FMath::Min(Events, FMath::FloorToInt32((Now - Start) * EventRate) + 1);
+		for (; Injected < Due; ++Injected)
+		{
+			const FString Entity = WakatimeBenchmark::EntityName(Injected);
+			UPackage* SavedPackage = (Injected % 4 == 1) ? CreatePackage(*Entity) : nullptr;
+
+			const uint64 BeginCycles = FPlatformTime::Cycles64();
+			InjectEvent(Module, Injected, SavedPackage);
+			GameThreadMicros.Add(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - BeginCycles) * 1000.0);
+			InjectTimes.Add(Entity, FPlatformTime::Seconds());
+		}
+
+		if (Now - LastHeartbeat >= 1.0) {
+			Module.SendHeartbeat();
+			LastHeartbeat = Now;
+		}
+		RenewRefusedToken();
+		PumpEngine(static_cast<float>(Now - LastTick));
+		LastTick = Now;
+		FPlatformProcess::Sleep(0.001f);
+	}
+	const double InjectSeconds = FPlatformTime::Seconds() - Start;
+
+	// Drain phase: flush what is batched and keep ticking (including spool replay) until everything
+	// arrived or the timeout runs out
+	Module.SendHeartbeat();
+	Module.Uploader.Flush();
+	const double DrainStart = FPlatformTime::Seconds();
+	double LastHousekeeping = DrainStart;
+	while (Server.FirstSeen.Num() < Events && FPlatformTime::Seconds() - DrainStart < DrainTimeout)
+	{
+		const double Now = FPlatformTime::Seconds();
+		if (Now - LastHousekeeping >= 1.0) {
+			RenewRefusedToken();
+			Module.Uploader.Flush();
+			Module.Uploader.Tick();
+			LastHousekeeping = Now;
+		}
+		PumpEngine(static_cast<float>(Now - LastTick));
+		LastTick = Now;
+		FPlatformProcess::Sleep(0.005f);
+	}
+	const double DrainSeconds = FPlatformTime::Seconds() - DrainStart;
+
+	// Stats phase: the second fetch should be answered from the ETag
+	for (int32 Fetch = 0; Fetch < 2; ++Fetch)
+	{
+		const double FetchStart = FPlatformTime::Seconds();
+		while (Module.StatsRequest.IsValid() && FPlatformTime::Seconds() - FetchStart < RequestTimeout)
+		{
+			PumpEngine(0.005f);
+			FPlatformProcess::Sleep(0.005f);
+		}
+		Module.FetchTodayStats();
+		while (Module.StatsRequest.IsValid() && FPlatformTime::Seconds() - FetchStart < RequestTimeout)
+		{
+			PumpEngine(0.005f);
+			FPlatformProcess::Sleep(0.005f);
+		}
+	}
+
+	TArray<double> LatencyMs;
+	LatencyMs.Reserve(Server.FirstSeen.Num());
+	for (const TPair<FString, double>& Pair : InjectTimes)
+	{
+		if (const double* Seen = Server.FirstSeen.Find(Pair.Key)) {
+			LatencyMs.Add((*Seen - Pair.Value) * 1000.0);
+		}
+	}
+
+	TSharedRef<FJsonObject> Config = MakeShared<FJsonObject>();
+	Config->SetNumberField(TEXT("events"), Events);
+	Config->SetNumberField(TEXT("event_rate"), EventRate);
+	Config->SetNumberField(TEXT("latency_ms"), Faults.LatencyMs);
+	Config->SetNumberField(TEXT("rate_401"), Faults.Rate401);
+	Config->SetNumberField(TEXT("rate_429"), Faults.Rate429);
+	Config->SetNumberField(TEXT("rate_500"), Faults.Rate500);
+	Config->SetNumberField(TEXT("drop_rate"), Faults.DropRate);
+	Config->SetNumberField(TEXT("request_timeout"), RequestTimeout);
+	Config->SetNumberField(TEXT("batch_window"), Settings->WakatimeBatchWindow);
+	Config->SetNumberField(TEXT("max_batch_size"), Settings->WakatimeMaxBatchSize);
+	Config->SetNumberField(TEXT("max_in_flight"), Settings->WakatimeMaxInFlight);
+
+	TSharedRef<FJsonObject> Codes = MakeShared<FJsonObject>();
+	for (const TPair<int32, int32>& Pair : Server.ResponseCodes)
+	{
+		Codes->SetNumberField(FString::FromInt(Pair.Key), Pair.Value);
+	}
+
+	TSharedPtr<IPlugin> Plugin = IPluginManager::Get().FindPlugin(TEXT("WakatimeIntegration"));
+
+	TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+	Report->SetStringField(TEXT("plugin_version"), Plugin.IsValid() ? Plugin->GetDescriptor().VersionName : FString());
+	Report->SetStringField(TEXT("timestamp"), FDateTime::UtcNow().ToIso8601());
+	Report->SetObjectField(TEXT("config"), Config);
+	Report->SetNumberField(TEXT("inject_seconds"), InjectSeconds);
+	Report->SetNumberField(TEXT("drain_seconds"), DrainSeconds);
+	Report->SetNumberField(TEXT("requests"), Server.Requests);
+	Report->SetNumberField(TEXT("heartbeats_received"), Server.HeartbeatsReceived);
+	Report->SetNumberField(TEXT("entities_delivered"), Server.FirstSeen.Num());
+	Report->SetNumberField(TEXT("entities_missing"), Events - Server.FirstSeen.Num());
+	Report->SetNumberField(TEXT("duplicates"), Server.Duplicates);
+	Report->SetNumberField(TEXT("duplicates_from_dropped_responses"), Server.DuplicatesFromDrops);
+	Report->SetNumberField(TEXT("entities_rejected_401"), Server.Rejected401.Num());
+	Report->SetNumberField(TEXT("token_renewals"), TokenRenewals);
+	Report->SetNumberField(TEXT("payload_bytes"), static_cast<double>(Server.PayloadBytes));
+	Report->SetNumberField(TEXT("payload_bytes_per_heartbeat"), Server.HeartbeatsReceived > 0 ? static_cast<double>(Server.PayloadBytes) / Server.HeartbeatsReceived : 0.0);
+	Report->SetObjectField(TEXT("response_codes"), Codes);
+	Report->SetNumberField(TEXT("stats_requests"), Server.StatsRequests);
+	Report->SetNumberField(TEXT("stats_not_modified"), Server.StatsNotModified);
+	Report->SetObjectField(TEXT("end_to_end_latency_ms"), WakatimeBenchmark::MakeDistribution(MoveTemp(LatencyMs)));
+	Report->SetObjectField(TEXT("game_thread_us_per_event"), WakatimeBenchmark::MakeDistribution(MoveTemp(GameThreadMicros)));
+
+	FString Json;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	FJsonSerializer::Serialize(Report, Writer);
+	const bool bSaved = FFileHelper::SaveStringToFile(Json, *OutputPath);
+
+	UE_LOG(LogTemp, Display, TEXT("Wakatime Integration: Benchmark delivered %d/%d entities in %d requests (%lld bytes, %d duplicates)"),
+		Server.FirstSeen.Num(), Events, Server.Requests, Server.PayloadBytes, Server.Duplicates);
+	UE_LOG(LogTemp, Display, TEXT("Wakatime Integration: Benchmark report %s %s"), bSaved ? TEXT("written to") : TEXT("could not be written to"), *OutputPath);
+
+	// CI runs this commandlet; a lost or duplicated heartbeat has to fail the run, not just show up in the report.
+	// A heartbeat whose response was dropped is sent again by design, so only the other duplicates count.
+	const int32 UnexpectedDuplicates = Server.Duplicates - Server.DuplicatesFromDrops;
+	const bool bDelivered = Server.FirstSeen.Num() == Events && UnexpectedDuplicates == 0;
+	if (!bDelivered) {
+		UE_LOG(LogTemp, Error, TEXT("Wakatime Integration: Benchmark failed, %d of %d entities missing and %d unexpected duplicates"),
+			Events - Server.FirstSeen.Num(), Events, UnexpectedDuplicates);
+	}
+
+	// Put the plugin back the way it was; nothing from the run may reach the real endpoint
+	Module.Uploader.Shutdown();
+	TArray<FWakatimeEntityActivity> Discarded;
+	Module.ActivityTable.Drain(Discarded);
+	Module.OverflowActivity = FWakatimeEntityActivity();
+	Module.OverflowFolder.Reset();
+	Module.OverflowEntities = 0;
+	Module.Dirty = false;
+	Module.LastActivityTime = 0;
+	Module.LastEntity = FName(TEXT("None"));
+	Settings->WakatimeEndpoint = SavedEndpoint;
+	Settings->WakatimeBearerToken = SavedToken;
+	Settings->WakatimeMaxHeartbeatsPerFlush = SavedMaxHeartbeats;
+	FHttpModule::Get().SetHttpTotalTimeout(SavedTimeout);
+	Module.Uploader.Initialize(FString(), Module.bCoordinatorActive ? &Module.Coordinator : nullptr);
+	Server.Stop();
+	IFileManager::Get().DeleteDirectory(*BenchmarkSpool, false, true);
+
+	return bSaved && bDelivered ? 0 : 1;
+}
+
+void UWakatimeBenchmarkCommandlet::InjectEvent(FWakatimeIntegrationModule& Module, int32 Index, UPackage* SavedPackage)
+{
+	const FName PackageName(*WakatimeBenchmark::EntityName(Index));
+	const FAssetData AssetData(PackageName, FName(TEXT("/Game/WakatimeBenchmark")), FName(*FString::Printf(TEXT("Asset_%d"), Index)), UObject::StaticClass()->GetClassPathName());
+
+	switch (Index % 4)
+	{
+	case 0:
+		Module.OnAssetAdded(AssetData);
+		break;
+	case 1:
+		Module.OnObjectSaved(SavedPackage);
+		break;
+	case 2:
+		Module.OnAssetRenamed(AssetData, TEXT("/Game/WakatimeBenchmark/Old"));
+		break;
+	default:
+		Module.OnAssetRemoved(AssetData);
+		break;
+	}
+}
+
+void UWakatimeBenchmarkCommandlet::PumpEngine(float DeltaTime)
+{
+	FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+	FTSTicker::GetCoreTicker().Tick(DeltaTime);
+	FHttpModule::Get().GetHttpManager().Tick(DeltaTime);
+}
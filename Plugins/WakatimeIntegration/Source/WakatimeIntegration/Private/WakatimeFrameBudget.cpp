@@ -0,0 +1,88 @@
+#include "WakatimeFrameBudget.h"
+#include "WakatimeStats.h"
+#include "CoreGlobals.h"
+#include "HAL/PlatformTime.h"
+
+// Frames in a row under half the budget before full fidelity comes back; about two seconds at 144 Hz
+static const uint64 RecoveryFrames = 300;
+
+FWakatimeFrameBudget::FScope::FScope(FWakatimeFrameBudget& InBudget)
+	: Budget(InBudget)
+{
+	if (Budget.BudgetCycles == 0 || !IsInGameThread()) {
+		return;
+	}
+	bCounted = true;
+	if (Budget.Depth++ == 0) {
+		Budget.AdvanceFrame();
+		StartCycles = FPlatformTime::Cycles64();
+	}
+}
+
+FWakatimeFrameBudget::FScope::~FScope()
+{
+	if (!bCounted || --Budget.Depth > 0) {
+		return;
+	}
+
+	Budget.FrameCycles += FPlatformTime::Cycles64() - StartCycles;
+	if (!Budget.bDegraded && Budget.FrameCycles > Budget.BudgetCycles) {
+		// Degrade right away so the rest of a burst in this frame is already sampled
+		Budget.SetDegraded(true);
+	}
+}
+
+void FWakatimeFrameBudget::Configure(double BudgetSeconds, int32 InSampleRate)
+{
+	BudgetCycles = BudgetSeconds > 0.0 ? FMath::Max<uint64>(static_cast<uint64>(BudgetSeconds / FPlatformTime::GetSecondsPerCycle64()), 1) : 0;
+	SampleRate = static_cast<uint32>(FMath::Max(InSampleRate, 1));
+	if (BudgetCycles == 0 && bDegraded) {
+		SetDegraded(false);
+	}
+}
+
+bool FWakatimeFrameBudget::ShouldSample()
+{
+	if (!bDegraded || ++SampleCounter % SampleRate == 0) {
+		return true;
+	}
+	INC_DWORD_STAT(STAT_WakatimeIntegration_EventsSampledOut);
+	return false;
+}
+
+void FWakatimeFrameBudget::AdvanceFrame()
+{
+	const uint64 Now = GFrameCounter;
+	if (Now == Frame) {
+		return;
+	}
+
+	// The frame that just ended, then every frame in between that never called into the plugin
+	if (FrameCycles > BudgetCycles) {
+		INC_DWORD_STAT(STAT_WakatimeIntegration_BudgetOverruns);
+		QuietFrames = 0;
+	}
+	else if (FrameCycles * 2 > BudgetCycles) {
+		QuietFrames = 0;
+	}
+	else {
+		++QuietFrames;
+	}
+	QuietFrames += Now - Frame - 1;
+
+	Frame = Now;
+	FrameCycles = 0;
+	if (bDegraded && QuietFrames >= RecoveryFrames) {
+		SetDegraded(false);
+	}
+}
+
+void FWakatimeFrameBudget::SetDegraded(bool bInDegraded)
+{
+	bDegraded = bInDegraded;
+	SampleCounter = 0;
+	QuietFrames = 0;
+	UE_LOG(LogTemp, Verbose, TEXT("Wakatime Integration: %s"), bDegraded
+		? TEXT("Over the frame budget, sampling editor events.")
+		: TEXT("Back under the frame budget, recording every event."));
+}
@@ -0,0 +1,90 @@
+#include "WakatimeHeartbeat.h"
+#include "Misc/App.h"
+#include "Misc/EngineVersion.h"
+#include "HAL/PlatformProcess.h"
+
+static FString GetCurrentOSName()
+{
+#if PLATFORM_WINDOWS
+	return TEXT("Windows");
+#elif PLATFORM_MAC
+	return TEXT("Mac");
+#elif PLATFORM_LINUX
+	return TEXT("Linux");
+#elif PLATFORM_IOS
+	return TEXT("iOS");
+#elif PLATFORM_ANDROID
+	return TEXT("Android");
+#else
+	return TEXT("Unknown");
+#endif
+}
+
+void FWakatimeHeartbeatContext::Initialize()
+{
+	FString EngineVersionString = FEngineVersion::Current().ToString(EVersionComponent::Patch);
+	UserAgent = FString::Printf(TEXT("unreal-wakatime/%s"), *EngineVersionString);
+
+	StaticFields.Reset();
+	StaticFields += TEXT(",\"project\":");
+	FWakatimeHeartbeatWriter::AppendQuoted(StaticFields, FApp::GetProjectName());
+	StaticFields += TEXT(",\"language\":\"UnrealEngine\",\"editor\":\"Unreal Engine\",\"plugin\":");
+	FWakatimeHeartbeatWriter::AppendQuoted(StaticFields, UserAgent);
+	StaticFields += TEXT(",\"operating_system\":");
+	FWakatimeHeartbeatWriter::AppendQuoted(StaticFields, GetCurrentOSName());
+	StaticFields += TEXT(",\"machine\":");
+	FWakatimeHeartbeatWriter::AppendQuoted(StaticFields, FPlatformProcess::ComputerName());
+	StaticFields += TEXT(",\"lineno\":1,\"cursorpos\":0");
+}
+
+FWakatimeHeartbeatWriter::FWakatimeHeartbeatWriter()
+{
+	Buffer.Reserve(512);
+	EntityBuffer.Reserve(256);
+}
+
+const FString& FWakatimeHeartbeatWriter::Write(const FWakatimeHeartbeatEvent& Event, const FWakatimeHeartbeatContext& Context)
+{
+	EntityBuffer.Reset();
+	Event.Entity.AppendString(EntityBuffer);
+
+	Buffer.Reset();
+	Buffer += TEXT("{\"type\":\"file\",\"time\":");
+	Buffer.Appendf(TEXT("%lld"), Event.Time);
+	Buffer += TEXT(",\"entity\":");
+	AppendQuoted(Buffer, EntityBuffer);
+	Buffer += Event.bIsWrite ? TEXT(",\"is_write\":true") : TEXT(",\"is_write\":false");
+	Buffer += TEXT(",\"lines\":");
+	Buffer.AppendInt(Event.Lines);
+	if (Event.bDebugging) {
+		Buffer += TEXT(",\"category\":\"debugging\"");
+	}
+	Buffer += Context.StaticFields;
+	Buffer += TEXT("}");
+	return Buffer;
+}
+
+void FWakatimeHeartbeatWriter::AppendQuoted(FString& Out, FStringView Value)
+{
+	Out.AppendChar(TEXT('"'));
+	for (TCHAR Char : Value)
+	{
+		switch (Char)
+		{
+		case TEXT('"'): Out += TEXT("\\\""); break;
+		case TEXT('\\'): Out += TEXT("\\\\"); break;
+		case TEXT('\n'): Out += TEXT("\\n"); break;
+		case TEXT('\r'): Out += TEXT("\\r"); break;
+		case TEXT('\t'): Out += TEXT("\\t"); break;
+		default:
+			if (Char < 0x20) {
+				Out.Appendf(TEXT("\\u%04x"), static_cast<uint32>(Char));
+			}
+			else {
+				Out.AppendChar(Char);
+			}
+			break;
+		}
+	}
+	Out.AppendChar(TEXT('"'));
+}
@@ -0,0 +1,38 @@
+#include "WakatimeHeartbeatDedup.h"
+#include "WakatimeHeartbeat.h"
+#include "WakatimeStats.h"
+
+// Same window the server applies
+static const int64 DedupWindowSeconds = 120;
+
+FWakatimeHeartbeatDedup::FWakatimeHeartbeatDedup(int32 InMaxEntries)
+	: Sent(InMaxEntries)
+{
+}
+
+bool FWakatimeHeartbeatDedup::ShouldSend(const FWakatimeHeartbeatEvent& Event)
+{
+	++Lookups;
+	const FKey Key{ Event.Entity, Event.bDebugging };
+	FSent* Previous = Sent.FindAndTouch(Key);
+
+	// Evicted entries can be older than the last one sent, so the window applies both ways
+	if (Previous && Event.Lines == 0 && Previous->bIsWrite == Event.bIsWrite
+		&& FMath::Abs(Event.Time - Previous->Time) < DedupWindowSeconds)
+	{
+		++Hits;
+		INC_DWORD_STAT(STAT_WakatimeIntegration_HeartbeatsDeduplicated);
+		SET_FLOAT_STAT(STAT_WakatimeIntegration_DedupHitRate, GetHitRate() * 100.0);
+		return false;
+	}
+
+	if (Previous) {
+		Previous->Time = Event.Time;
+		Previous->bIsWrite = Event.bIsWrite;
+	}
+	else {
+		Sent.Add(Key, FSent{ Event.Time, Event.bIsWrite });
+	}
+	SET_FLOAT_STAT(STAT_WakatimeIntegration_DedupHitRate, GetHitRate() * 100.0);
+	return true;
+}
@@ -0,0 +1,314 @@
+#include "WakatimeInstanceCoordinator.h"
+#include "WakatimeStats.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+// Bump RingVersion whenever the shared layout changes; it is part of the segment name, so processes
+// running different plugin versions simply don't see each other.
+static const uint32 RingMagic = 0x574B5452; // 'WKTR'
+static const uint32 RingVersion = 1;
+static const uint64 RingSlots = 256;
+static const uint32 SlotPayloadBytes = 2036;
+
+// A slot claimed but not published for this long belongs to a writer that died mid-copy
+static const double StallTimeoutSeconds = 5.0;
+
+static_assert(std::atomic<uint64>::is_always_lock_free && std::atomic<uint32>::is_always_lock_free,
+	"The shared ring needs address-free atomics");
+static_assert((RingSlots & (RingSlots - 1)) == 0, "RingSlots must be a power of two");
+
+struct FWakatimeSharedHeader
+{
+	uint32 Magic;
+	uint32 Version;
+	std::atomic<uint32> LeaderPid;
+	std::atomic<int32> TodayDayOfYear;
+	std::atomic<uint64> TodaySecondsBits;
+
+	// Producers in every follower contend on WriteIndex; keep the leader's ReadIndex off that line
+	alignas(64) std::atomic<uint64> WriteIndex;
+	alignas(64) std::atomic<uint64> ReadIndex;
+};
+
+struct FWakatimeSharedSlot
+{
+	std::atomic<uint64> Sequence;
+	uint32 Length;
+	ANSICHAR Payload[SlotPayloadBytes];
+};
+
+static SIZE_T GetRegionSize()
+{
+	return Align(sizeof(FWakatimeSharedHeader), 64) + RingSlots * sizeof(FWakatimeSharedSlot);
+}
+
+void FWakatimeInstanceCoordinator::Initialize(FOnForwarded InOnForwarded)
+{
+	OnForwarded = MoveTemp(InOnForwarded);
+
+	// One leader per user and machine, whatever project or engine build the editors run
+	const uint32 UserHash = FCrc::StrCrc32(FPlatformProcess::UserName());
+	LockFilePath = FPaths::Combine(FPlatformProcess::UserSettingsDir(), TEXT("UnrealEngine"), TEXT("Wakatime"), TEXT("Leader.lock"));
+	RegionName = FString::Printf(TEXT("WakatimeIntegration-%08x-v%u"), UserHash, RingVersion);
+
+	Elect();
+
+	TickHandle = FTSTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateRaw(this, &FWakatimeInstanceCoordinator::OnTick),
+		1.0f
+	);
+}
+
+void FWakatimeInstanceCoordinator::Shutdown()
+{
+	if (TickHandle.IsValid()) {
+		FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+		TickHandle.Reset();
+	}
+
+	if (IsLeader()) {
+		Drain();
+	}
+	Detach();
+	bLeader.store(false, std::memory_order_release);
+
+	if (LockHandle) {
+		delete LockHandle;
+		LockHandle = nullptr;
+	}
+}
+
+bool FWakatimeInstanceCoordinator::OnTick(float DeltaTime)
+{
+	WAKATIME_SCOPE(InstanceTick);
+	if (IsLeader()) {
+		Drain();
+		return true;
+	}
+
+	bool bLeaderGone = true;
+	{
+		FScopeLock Lock(&MappingLock);
+		if (Header) {
+			const uint32 LeaderPid = Header->LeaderPid.load(std::memory_order_acquire);
+			bLeaderGone = LeaderPid == 0 || !FPlatformProcess::IsApplicationRunning(LeaderPid);
+		}
+	}
+	if (bLeaderGone) {
+		Detach();
+		Elect();
+	}
+	return true;
+}
+
+void FWakatimeInstanceCoordinator::Elect()
+{
+	if (!LockHandle) {
+		// OpenWrite is exclusive against other writers and the OS drops the handle with the process,
+		// so whoever holds it is the leader until it exits or crashes.
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		PlatformFile.CreateDirectoryTree(*FPaths::GetPath(LockFilePath));
+		LockHandle = PlatformFile.OpenWrite(*LockFilePath, false, true);
+	}
+
+	if (!LockHandle) {
+		bLeader.store(false, std::memory_order_release);
+		Attach(false);
+		return;
+	}
+
+	if (!Attach(true)) {
+		// No shared memory here; lead anyway so this process keeps uploading, nobody can forward to it
+		UE_LOG(LogTemp, Log, TEXT("Wakatime Integration: Shared memory unavailable, uploading from this process only."));
+		bLeader.store(true, std::memory_order_release);
+		return;
+	}
+
+	const uint32 Pid = FPlatformProcess::GetCurrentProcessId();
+	FScopeLock Lock(&MappingLock);
+	const uint32 PreviousPid = Header->LeaderPid.load(std::memory_order_acquire);
+	if (PreviousPid != 0 && PreviousPid != Pid && FPlatformProcess::IsApplicationRunning(PreviousPid)) {
+		// The lockfile wasn't exclusive on this platform after all; the running leader wins
+		delete LockHandle;
+		LockHandle = nullptr;
+		bLeader.store(false, std::memory_order_release);
+		return;
+	}
+
+	// A ring left behind by a crashed leader still holds valid heartbeats; only a foreign layout is reset
+	if (Header->Magic != RingMagic || Header->Version != RingVersion) {
+		Header->WriteIndex.store(0, std::memory_order_relaxed);
+		Header->ReadIndex.store(0, std::memory_order_relaxed);
+		for (uint64 Index = 0; Index < RingSlots; ++Index)
+		{
+			GetSlot(Index)->Sequence.store(Index, std::memory_order_relaxed);
+		}
+		Header->TodayDayOfYear.store(-1, std::memory_order_relaxed);
+		Header->Magic = RingMagic;
+		Header->Version = RingVersion;
+	}
+	StalledSince = 0.0;
+	Header->LeaderPid.store(Pid, std::memory_order_release);
+	bLeader.store(true, std::memory_order_release);
+
+	UE_LOG(LogTemp, Log, TEXT("Wakatime Integration: Uploading for all editors on this machine."));
+}
+
+bool FWakatimeInstanceCoordinator::Attach(bool bCreate)
+{
+	FScopeLock Lock(&MappingLock);
+	if (Header) {
+		return true;
+	}
+
+	const uint32 Access = static_cast<uint32>(FPlatformMemory::ESharedMemoryAccess::Read) | static_cast<uint32>(FPlatformMemory::ESharedMemoryAccess::Write);
+	Region = FPlatformMemory::MapNamedSharedMemoryRegion(RegionName, bCreate, Access, GetRegionSize());
+	if (!Region && bCreate) {
+		// Left behind by a leader that crashed
+		Region = FPlatformMemory::MapNamedSharedMemoryRegion(RegionName, false, Access, GetRegionSize());
+	}
+	if (!Region) {
+		return false;
+	}
+
+	Header = static_cast<FWakatimeSharedHeader*>(Region->GetAddress());
+	return true;
+}
+
+void FWakatimeInstanceCoordinator::Detach()
+{
+	FScopeLock Lock(&MappingLock);
+	if (!Header) {
+		return;
+	}
+
+	if (IsLeader()) {
+		uint32 Pid = FPlatformProcess::GetCurrentProcessId();
+		Header->LeaderPid.compare_exchange_strong(Pid, 0, std::memory_order_acq_rel);
+	}
+	FPlatformMemory::UnmapNamedSharedMemoryRegion(Region);
+	Region = nullptr;
+	Header = nullptr;
+}
+
+FWakatimeSharedSlot* FWakatimeInstanceCoordinator::GetSlot(uint64 Index) const
+{
+	uint8* Slots = reinterpret_cast<uint8*>(Header) + Align(sizeof(FWakatimeSharedHeader), 64);
+	return reinterpret_cast<FWakatimeSharedSlot*>(Slots) + (Index & (RingSlots - 1));
+}
+
+bool FWakatimeInstanceCoordinator::Forward(const FString& Heartbeat)
+{
+	FTCHARToUTF8 Utf8(*Heartbeat);
+	if (Utf8.Length() > static_cast<int32>(SlotPayloadBytes)) {
+		return false;
+	}
+
+	FScopeLock Lock(&MappingLock);
+	if (!Header || IsLeader() || Header->LeaderPid.load(std::memory_order_acquire) == 0) {
+		return false;
+	}
+
+	// Bounded MPSC ring: a slot is free for position Pos when its sequence equals Pos, and holds
+	// data for the reader once the writer has bumped it to Pos + 1.
+	uint64 Pos = Header->WriteIndex.load(std::memory_order_relaxed);
+	FWakatimeSharedSlot* Slot = nullptr;
+	for (;;)
+	{
+		Slot = GetSlot(Pos);
+		const int64 Diff = static_cast<int64>(Slot->Sequence.load(std::memory_order_acquire)) - static_cast<int64>(Pos);
+		if (Diff == 0) {
+			if (Header->WriteIndex.compare_exchange_weak(Pos, Pos + 1, std::memory_order_relaxed)) {
+				break;
+			}
+		}
+		else if (Diff < 0) {
+			// Full; the leader is behind, so upload this one ourselves
+			return false;
+		}
+		else {
+			Pos = Header->WriteIndex.load(std::memory_order_relaxed);
+		}
+	}
+
+	Slot->Length = Utf8.Length();
+	FMemory::Memcpy(Slot->Payload, Utf8.Get(), Utf8.Length());
+	Slot->Sequence.store(Pos + 1, std::memory_order_release);
+	return true;
+}
+
+void FWakatimeInstanceCoordinator::Drain()
+{
+	TArray<FString> Heartbeats;
+	{
+		FScopeLock Lock(&MappingLock);
+		if (!Header) {
+			return;
+		}
+
+		uint64 Pos = Header->ReadIndex.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			FWakatimeSharedSlot* Slot = GetSlot(Pos);
+			if (Slot->Sequence.load(std::memory_order_acquire) != Pos + 1) {
+				break;
+			}
+			if (Slot->Length <= SlotPayloadBytes) {
+				FUTF8ToTCHAR Converted(Slot->Payload, Slot->Length);
+				Heartbeats.Emplace(Converted.Length(), Converted.Get());
+			}
+			Slot->Sequence.store(Pos + RingSlots, std::memory_order_release);
+			++Pos;
+		}
+		Header->ReadIndex.store(Pos, std::memory_order_relaxed);
+
+		const double Now = FPlatformTime::Seconds();
+		if (Heartbeats.Num() > 0 || Header->WriteIndex.load(std::memory_order_relaxed) == Pos) {
+			StalledSince = 0.0;
+		}
+		else if (StalledSince == 0.0) {
+			StalledSince = Now;
+		}
+		else if (Now - StalledSince > StallTimeoutSeconds) {
+			UE_LOG(LogTemp, Warning, TEXT("Wakatime Integration: Another editor stopped mid-write, resetting the shared heartbeat ring."));
+			for (uint64 Index = 0; Index < RingSlots; ++Index)
+			{
+				GetSlot(Pos + Index)->Sequence.store(Pos + Index, std::memory_order_relaxed);
+			}
+			Header->WriteIndex.store(Pos, std::memory_order_release);
+			StalledSince = 0.0;
+		}
+	}
+
+	if (Heartbeats.Num() > 0) {
+		INC_DWORD_STAT_BY(STAT_WakatimeIntegration_HeartbeatsReceived, Heartbeats.Num());
+		OnForwarded(MoveTemp(Heartbeats));
+	}
+}
+
+void FWakatimeInstanceCoordinator::PublishTodaySeconds(double Seconds, int32 DayOfYear)
+{
+	FScopeLock Lock(&MappingLock);
+	if (!Header || !IsLeader()) {
+		return;
+	}
+	uint64 Bits = 0;
+	FMemory::Memcpy(&Bits, &Seconds, sizeof(Bits));
+	Header->TodaySecondsBits.store(Bits, std::memory_order_relaxed);
+	Header->TodayDayOfYear.store(DayOfYear, std::memory_order_release);
+}
+
+bool FWakatimeInstanceCoordinator::GetTodaySeconds(int32 DayOfYear, double& OutSeconds) const
+{
+	FScopeLock Lock(&MappingLock);
+	if (!Header || IsLeader() || Header->LeaderPid.load(std::memory_order_acquire) == 0
+		|| Header->TodayDayOfYear.load(std::memory_order_acquire) != DayOfYear)
+	{
+		return false;
+	}
+	const uint64 Bits = Header->TodaySecondsBits.load(std::memory_order_relaxed);
+	FMemory::Memcpy(&OutSeconds, &Bits, sizeof(Bits));
+	return true;
+}
@@ -4,32 +4,45 @@
 #include "Modules/ModuleManager.h"
 #include "AssetRegistry/AssetRegistryModule.h"
 #include "UObject/UObjectGlobals.h"
-#include "HttpModule.h"
-#include "Interfaces/IHttpRequest.h"
-#include "Interfaces/IHttpResponse.h"
+#include "UObject/Package.h"
+#include "Misc/PackageName.h"
+#include "Async/Async.h"
 #include "Containers/Ticker.h"
 #include "WakatimeSettings.h"
+#include "WakatimeStats.h"
 #include "ISettingsModule.h"
-#include "Misc/App.h"
-#include "Misc/EngineVersion.h"
-#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/IConsoleManager.h"
+#include "HttpModule.h"
+#include "Misc/DateTime.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "ToolMenus.h"
+#include "Framework/Application/SlateApplication.h"
+#include "Misc/CoreDelegates.h"
+#include "Editor.h"
+#include "Editor/TransBuffer.h"
+#include "Editor/EditorEngine.h"
+#include "Engine/World.h"
+#include "Widgets/Layout/SBox.h"
+#include "Widgets/Text/STextBlock.h"
 #include <chrono>
 
 #define LOCTEXT_NAMESPACE "FWakatimeIntegrationModule"
 
 IMPLEMENT_MODULE(FWakatimeIntegrationModule, WakatimeIntegration)
 
+// How far the heartbeat timer may back off while nobody touches the editor
+static const float MaxIdleTimerDelay = 600.0f;
+
 void FWakatimeIntegrationModule::StartupModule()
 {
+	SyncClock();
+	AliveToken = MakeShared<bool, ESPMode::ThreadSafe>(true);
 	Dirty = false;
-	DeleteOperations = 0;
-	SaveOperations = 0;
-	RenameOperations = 0;
-	AddOperations = 0;
-	LastAssetPushTime = -1;
 	LastActivityTime = 0;
-	SaveDebounce = 2;
-	LastSavedName = FName(TEXT("None"));
+	LastEntity = FName(TEXT("None"));
 
 	if (ISettingsModule* SettingsModule = FModuleManager::GetModulePtr<ISettingsModule>("Settings")) {
 		SettingsModule->RegisterSettings("Editor", "Plugins", "Wakatime_Settings",
@@ -41,17 +54,66 @@ void FWakatimeIntegrationModule::StartupModule()
 	const UWakatimeSettings* Settings = GetDefault<UWakatimeSettings>();
 	const float TimerDuration = Settings->WakatimeInterval;
 
+	// Only one editor on this machine uploads; the others forward their heartbeats to it.
+	// Commandlets are short-lived and may point the uploader elsewhere, so they keep to themselves.
+	bCoordinatorActive = Settings->bWakatimeShareUploads && !IsRunningCommandlet();
+	if (bCoordinatorActive) {
+		Coordinator.Initialize([this](TArray<FString>&& Heartbeats)
+		{
+			Uploader.EnqueueSerialized(MoveTemp(Heartbeats));
+		});
+	}
+	Uploader.Initialize(FString(), bCoordinatorActive ? &Coordinator : nullptr);
+
+	// Local history for Wakatime.Report; commandlets only read it
+	if (!IsRunningCommandlet()) {
+		ActivityStore.Initialize(FWakatimeActivityStore::GetDefaultDirectory());
+	}
+
+	for (FWakatimeTokenBucket& Bucket : EventBuckets)
+	{
+		Bucket.Configure(Settings->WakatimeEventFlushRate / 60.0, Settings->WakatimeEventFlushBurst);
+	}
+	ConfigureFrameBudget();
+
+	// The initial scan reports every asset in the project through OnAssetAdded; none of that is
+	// user activity, so the registry events are only subscribed once discovery has finished.
 	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
-	AssetRegistry.OnAssetAdded().AddRaw(this, &FWakatimeIntegrationModule::OnAssetAdded);
-	AssetRegistry.OnAssetRemoved().AddRaw(this, &FWakatimeIntegrationModule::OnAssetRemoved);
-	AssetRegistry.OnAssetRenamed().AddRaw(this, &FWakatimeIntegrationModule::OnAssetRenamed);
+	if (AssetRegistry.IsLoadingAssets()) {
+		AssetRegistry.OnFilesLoaded().AddRaw(this, &FWakatimeIntegrationModule::OnAssetRegistryFilesLoaded);
+	}
+	else {
+		OnAssetRegistryFilesLoaded();
+	}
 
-	FCoreUObjectDelegates::OnObjectSaved.AddRaw(this, &FWakatimeIntegrationModule::OnObjectSaved);
-	FCoreUObjectDelegates::OnObjectModified.AddRaw(this, &FWakatimeIntegrationModule::OnObjectModified);
+	// Activity comes from Slate's input bookkeeping and the editor's undo buffer, which are only
+	// there once the engine is up
+	if (FSlateApplication::IsInitialized() && GEditor) {
+		BindEditorHooks();
+	}
+	else {
+		FCoreDelegates::OnPostEngineInit.AddRaw(this, &FWakatimeIntegrationModule::BindEditorHooks);
+	}
+	FEditorDelegates::PostPIEStarted.AddRaw(this, &FWakatimeIntegrationModule::OnPostPieStarted);
+	FEditorDelegates::PrePIEEnded.AddRaw(this, &FWakatimeIntegrationModule::OnPrePieEnded);
 
-	TimerHandle = FTSTicker::GetCoreTicker().AddTicker(
-		FTickerDelegate::CreateRaw(this, &FWakatimeIntegrationModule::OnTimerTick),
-		TimerDuration
+	ScheduleTimerTick(TimerDuration);
+
+	StatsTimerHandle = FTSTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateRaw(this, &FWakatimeIntegrationModule::OnStatsTick),
+		1.0f
+	);
+	UToolMenus::RegisterStartupCallback(FSimpleMulticastDelegate::FDelegate::CreateRaw(this, &FWakatimeIntegrationModule::RegisterToolbarExtension));
+
+	BenchmarkCommand = IConsoleManager::Get().RegisterConsoleCommand(
+		TEXT("Wakatime.BenchmarkActivity"),
+		TEXT("Times the activity ingestion path against the old locked implementation. Usage: Wakatime.BenchmarkActivity [Iterations]"),
+		FConsoleCommandWithArgsDelegate::CreateRaw(this, &FWakatimeIntegrationModule::BenchmarkActivity)
+	);
+	ReportCommand = IConsoleManager::Get().RegisterConsoleCommand(
+		TEXT("Wakatime.Report"),
+		TEXT("Logs time per asset, folder or category from the local activity store. Usage: Wakatime.Report [Days=1] [asset|folder|category] [Top=20]"),
+		FConsoleCommandWithArgsDelegate::CreateRaw(this, &FWakatimeIntegrationModule::ReportActivity)
 	);
 
 	UE_LOG(LogTemp, Log, TEXT("Wakatime Integration Startup"));
@@ -62,6 +124,7 @@ void FWakatimeIntegrationModule::ShutdownModule()
 	if (FModuleManager::Get().IsModuleLoaded("AssetRegistry"))
 	{
 		IAssetRegistry& AssetRegistry = FModuleManager::GetModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+		AssetRegistry.OnFilesLoaded().RemoveAll(this);
 		AssetRegistry.OnAssetAdded().RemoveAll(this);
 		AssetRegistry.OnAssetRemoved().RemoveAll(this);
 		AssetRegistry.OnAssetRenamed().RemoveAll(this);
@@ -72,258 +135,760 @@ void FWakatimeIntegrationModule::ShutdownModule()
 		}
 	}
 
-	FCoreUObjectDelegates::OnObjectSaved.RemoveAll(this);
-	FCoreUObjectDelegates::OnObjectModified.RemoveAll(this);
+	AliveToken.Reset();
+	FCoreDelegates::OnPostEngineInit.RemoveAll(this);
+	FEditorDelegates::PostPIEStarted.RemoveAll(this);
+	FEditorDelegates::PrePIEEnded.RemoveAll(this);
+	UnbindEditorHooks();
 
 	FTSTicker::GetCoreTicker().RemoveTicker(TimerHandle);
+	TimerHandle.Reset();
+	FTSTicker::GetCoreTicker().RemoveTicker(StatsTimerHandle);
+
+	if (StatsRequest.IsValid()) {
+		StatsRequest->OnProcessRequestComplete().Unbind();
+		StatsRequest->CancelRequest();
+		StatsRequest.Reset();
+	}
+
+	if (UObjectInitialized()) {
+		UToolMenus::UnRegisterStartupCallback(this);
+		UToolMenus::UnregisterOwner(this);
+	}
+
+	if (BenchmarkCommand) {
+		IConsoleManager::Get().UnregisterConsoleObject(BenchmarkCommand);
+		BenchmarkCommand = nullptr;
+	}
+	if (ReportCommand) {
+		IConsoleManager::Get().UnregisterConsoleObject(ReportCommand);
+		ReportCommand = nullptr;
+	}
+
+	SendHeartbeat();
+	ActivityStore.Shutdown();
+	if (bCoordinatorActive) {
+		Coordinator.Shutdown();
+		bCoordinatorActive = false;
+	}
+	Uploader.Shutdown();
 
 	UE_LOG(LogTemp, Log, TEXT("Wakatime Integration Shutdown"));
 }
 
+void FWakatimeIntegrationModule::ConfigureFrameBudget()
+{
+	// Commandlets never advance the frame counter, so everything would land in one endless frame
+	const UWakatimeSettings* Settings = GetDefault<UWakatimeSettings>();
+	const double Budget = IsRunningCommandlet() ? 0.0 : Settings->WakatimeFrameBudgetMicroseconds / 1000000.0;
+	FrameBudget.Configure(Budget, Settings->WakatimeDegradedSampleRate);
+}
+
 void FWakatimeIntegrationModule::MarkActivity()
 {
-	int64 now = GetCurrentTime();
-	FScopeLock Lock(&DataLock);
-	Dirty = true;
-	LastActivityTime = now;
+	// Only write when something actually changes; a burst of calls within the same second
+	// is a pair of relaxed loads.
+	const int64 now = GetCurrentTime();
+	if (LastActivityTime.load(std::memory_order_relaxed) != now) {
+		LastActivityTime.store(now, std::memory_order_relaxed);
+	}
+	if (!Dirty.load(std::memory_order_relaxed)) {
+		Dirty.store(true, std::memory_order_release);
+	}
 }
 
-void FWakatimeIntegrationModule::OnAssetAdded(const FAssetData& AssetData)
+void FWakatimeIntegrationModule::OnAssetRegistryFilesLoaded()
 {
-	int64 now = GetCurrentTime();
-	if ((now - LastAssetPushTime) < SaveDebounce) {
-		return;
+	IAssetRegistry& AssetRegistry = FModuleManager::GetModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+	AssetRegistry.OnFilesLoaded().RemoveAll(this);
+	AssetRegistry.OnAssetAdded().AddRaw(this, &FWakatimeIntegrationModule::OnAssetAdded);
+	AssetRegistry.OnAssetRemoved().AddRaw(this, &FWakatimeIntegrationModule::OnAssetRemoved);
+	AssetRegistry.OnAssetRenamed().AddRaw(this, &FWakatimeIntegrationModule::OnAssetRenamed);
+}
+
+void FWakatimeIntegrationModule::FlushIfAllowed(EWakatimeEventClass EventClass)
+{
+	// Events are always recorded; the bucket only decides whether this one also flushes a heartbeat
+	// right away. Whatever it holds back goes out with the next timer tick, as does everything
+	// while the plugin is over its frame budget.
+	if (FrameBudget.IsDegraded()) {
+		INC_DWORD_STAT(STAT_WakatimeIntegration_FlushesRateLimited);
+	}
+	else if (EventBuckets[static_cast<int32>(EventClass)].TryConsume(FPlatformTime::Seconds())) {
+		SendHeartbeat();
 	}
-	LastAssetPushTime = now;
+	else {
+		INC_DWORD_STAT(STAT_WakatimeIntegration_FlushesRateLimited);
+	}
+}
 
+static FString CommonFolder(const FString& A, const FString& B)
+{
+	int32 Len = 0;
+	while (Len < A.Len() && Len < B.Len() && A[Len] == B[Len])
 	{
-		FScopeLock Lock(&DataLock);
-		Dirty = true;
-		AddOperations++;
-		LastActivityTime = now;
+		++Len;
 	}
-	SendHeartbeat();
+	// Only cut at a folder boundary, so /Game/Props and /Game/PropsOld share /Game
+	const bool bWholeFolder = (Len == A.Len() || A[Len] == TEXT('/')) && (Len == B.Len() || B[Len] == TEXT('/'));
+	if (!bWholeFolder) {
+		while (Len > 0 && A[Len - 1] != TEXT('/'))
+		{
+			--Len;
+		}
+	}
+	while (Len > 0 && A[Len - 1] == TEXT('/'))
+	{
+		--Len;
+	}
+	return A.Left(Len);
 }
 
-void FWakatimeIntegrationModule::OnAssetRemoved(const FAssetData& AssetData)
+void FWakatimeIntegrationModule::AddToOverflow(const FWakatimeEntityActivity& Activity)
 {
-	int64 now = GetCurrentTime();
-	if ((now - LastAssetPushTime) < SaveDebounce) {
-		return;
+	const FString Folder = FPackageName::GetLongPackagePath(Activity.Package.ToString());
+	OverflowFolder = OverflowEntities == 0 ? Folder : CommonFolder(OverflowFolder, Folder);
+	OverflowActivity.Merge(Activity);
+	++OverflowEntities;
+	INC_DWORD_STAT(STAT_WakatimeIntegration_EntitiesAggregated);
+}
+
+FWakatimeEntityActivity* FWakatimeIntegrationModule::RecordActivity(FName Package)
+{
+	MarkActivity();
+	if (Package.IsNone() || !IsInGameThread()) {
+		return nullptr;
 	}
-	LastAssetPushTime = now;
 
-	{
-		FScopeLock Lock(&DataLock);
-		Dirty = true;
-		DeleteOperations++;
-		LastActivityTime = now;
+	FWakatimeEntityActivity Evicted;
+	bool bEvicted = false;
+	FWakatimeEntityActivity& Entry = ActivityTable.FindOrAdd(Package, LastActivityTime.load(std::memory_order_relaxed), Evicted, bEvicted);
+	if (bEvicted) {
+		// The table is full (mass import); fold the stalest entity into the aggregate instead of growing
+		AddToOverflow(Evicted);
 	}
-	SendHeartbeat();
+	LastEntity = Package;
+	return &Entry;
+}
+
+void FWakatimeIntegrationModule::OnAssetAdded(const FAssetData& AssetData)
+{
+	WAKATIME_SCOPE(OnAssetAdded);
+	FWakatimeFrameBudget::FScope BudgetScope(FrameBudget);
+	INC_DWORD_STAT(STAT_WakatimeIntegration_EventsAssetAdded);
+	if (!FrameBudget.ShouldSample()) {
+		MarkActivity();
+	}
+	else if (FWakatimeEntityActivity* Entry = RecordActivity(AssetData.PackageName)) {
+		++Entry->Additions;
+	}
+	FlushIfAllowed(EWakatimeEventClass::AssetAdded);
+}
+
+void FWakatimeIntegrationModule::OnAssetRemoved(const FAssetData& AssetData)
+{
+	WAKATIME_SCOPE(OnAssetRemoved);
+	FWakatimeFrameBudget::FScope BudgetScope(FrameBudget);
+	INC_DWORD_STAT(STAT_WakatimeIntegration_EventsAssetRemoved);
+	if (!FrameBudget.ShouldSample()) {
+		MarkActivity();
+	}
+	else if (FWakatimeEntityActivity* Entry = RecordActivity(AssetData.PackageName)) {
+		++Entry->Deletions;
+	}
+	FlushIfAllowed(EWakatimeEventClass::AssetRemoved);
 }
 
 void FWakatimeIntegrationModule::OnAssetRenamed(const FAssetData& AssetData, const FString& OldPath)
 {
-	int64 now = GetCurrentTime();
-	if ((now - LastAssetPushTime) < SaveDebounce) {
-		return;
+	WAKATIME_SCOPE(OnAssetRenamed);
+	FWakatimeFrameBudget::FScope BudgetScope(FrameBudget);
+	INC_DWORD_STAT(STAT_WakatimeIntegration_EventsAssetRenamed);
+	if (FWakatimeEntityActivity* Entry = RecordActivity(AssetData.PackageName)) {
+		++Entry->Renames;
+		Entry->bIsWrite = true;
+	}
+	FlushIfAllowed(EWakatimeEventClass::AssetRenamed);
+}
+
+void FWakatimeIntegrationModule::OnObjectSaved(UObject* SavedObject)
+{
+	WAKATIME_SCOPE(OnObjectSaved);
+	FWakatimeFrameBudget::FScope BudgetScope(FrameBudget);
+	INC_DWORD_STAT(STAT_WakatimeIntegration_EventsObjectSaved);
+	if (FWakatimeEntityActivity* Entry = RecordActivity(SavedObject->GetPackage()->GetFName())) {
+		++Entry->Saves;
+		Entry->bIsWrite = true;
 	}
-	LastAssetPushTime = now;
+	FlushIfAllowed(EWakatimeEventClass::ObjectSaved);
+}
 
+void FWakatimeIntegrationModule::OnTransactionStateChanged(const FTransactionContext& TransactionContext, ETransactionStateEventType TransactionState)
+{
+	// One sample per undoable action (or undo/redo of one), however many objects it touched.
+	// Nested transactions only report the outermost one.
+	if (TransactionState != ETransactionStateEventType::TransactionFinalized
+		&& TransactionState != ETransactionStateEventType::UndoRedoFinalized)
 	{
-		FScopeLock Lock(&DataLock);
-		Dirty = true;
-		RenameOperations++;
-		LastActivityTime = now;
+		return;
+	}
+
+	WAKATIME_SCOPE(OnTransaction);
+	FWakatimeFrameBudget::FScope BudgetScope(FrameBudget);
+	INC_DWORD_STAT(STAT_WakatimeIntegration_EventsTransaction);
+	UObject* PrimaryObject = TransactionContext.PrimaryObject;
+	UPackage* Package = PrimaryObject ? PrimaryObject->GetPackage() : nullptr;
+	if (!Package || Package == GetTransientPackage() || !FrameBudget.ShouldSample()) {
+		MarkActivity();
+		return;
 	}
+	if (FWakatimeEntityActivity* Entry = RecordActivity(Package->GetFName())) {
+		++Entry->Modifications;
+	}
+}
+
+void FWakatimeIntegrationModule::BindEditorHooks()
+{
+	FCoreDelegates::OnPostEngineInit.RemoveAll(this);
+	FCoreUObjectDelegates::OnObjectSaved.AddRaw(this, &FWakatimeIntegrationModule::OnObjectSaved);
+
+	if (GEditor) {
+		if (UTransBuffer* TransBuffer = Cast<UTransBuffer>(GEditor->Trans)) {
+			TransBuffer->OnTransactionStateChanged().AddRaw(this, &FWakatimeIntegrationModule::OnTransactionStateChanged);
+		}
+	}
+
+	if (FSlateApplication::IsInitialized()) {
+		FSlateApplication& SlateApplication = FSlateApplication::Get();
+		LastSeenInteractionTime = SlateApplication.GetLastUserInteractionTime();
+		UserInteractionHandle = SlateApplication.GetLastUserInteractionTimeUpdateEvent().AddRaw(this, &FWakatimeIntegrationModule::OnUserInteraction);
+		ActivationChangedHandle = SlateApplication.OnApplicationActivationStateChanged().AddRaw(this, &FWakatimeIntegrationModule::OnApplicationActivationChanged);
+	}
+}
+
+void FWakatimeIntegrationModule::UnbindEditorHooks()
+{
+	FCoreUObjectDelegates::OnObjectSaved.RemoveAll(this);
+	if (FSlateApplication::IsInitialized()) {
+		FSlateApplication::Get().GetLastUserInteractionTimeUpdateEvent().Remove(UserInteractionHandle);
+		FSlateApplication::Get().OnApplicationActivationStateChanged().Remove(ActivationChangedHandle);
+	}
+	UserInteractionHandle.Reset();
+	ActivationChangedHandle.Reset();
+	if (GEditor && UObjectInitialized()) {
+		if (UTransBuffer* TransBuffer = Cast<UTransBuffer>(GEditor->Trans)) {
+			TransBuffer->OnTransactionStateChanged().RemoveAll(this);
+		}
+	}
+}
+
+void FWakatimeIntegrationModule::OnPostPieStarted(bool bIsSimulating)
+{
+	// PIE saves, spawns and modifies runtime objects every frame and takes all input; none of it is
+	// editing. Unbind everything that would fire for it and let the heartbeat timer report the
+	// session as debugging time instead, so the plugin costs nothing inside the PIE frame loop.
+	if (bInPie) {
+		return;
+	}
+	bInPie = true;
+	INC_DWORD_STAT(STAT_WakatimeIntegration_PieSessions);
+
+	UnbindEditorHooks();
 	SendHeartbeat();
+
+	PieEntity = LastEntity;
+	if (GEditor) {
+		if (UWorld* EditorWorld = GEditor->GetEditorWorldContext().World()) {
+			PieEntity = EditorWorld->GetOutermost()->GetFName();
+		}
+	}
+
+	ScheduleTimerTick(0.0f);
 }
 
-void FWakatimeIntegrationModule::OnObjectSaved(UObject* SavedObject)
+void FWakatimeIntegrationModule::OnPrePieEnded(bool bIsSimulating)
 {
-	int64 now = GetCurrentTime();
-	if ((now - LastAssetPushTime) < SaveDebounce) {
+	if (!bInPie) {
 		return;
 	}
-	LastAssetPushTime = now;
 
-	{
-		FScopeLock Lock(&DataLock);
-		SaveOperations++;
-		Dirty = true;
-		LastSavedName = SavedObject->GetFName();
-		LastActivityTime = now;
+	// Covers the tail of the session since the last timer tick
+	SendDebuggingHeartbeat();
+	bInPie = false;
+
+	BindEditorHooks();
+	ScheduleTimerTick(GetDefault<UWakatimeSettings>()->WakatimeInterval);
+}
+
+void FWakatimeIntegrationModule::SendDebuggingHeartbeat()
+{
+	MarkActivity();
+
+	FWakatimeHeartbeatEvent Event;
+	Event.Entity = PieEntity;
+	Event.Time = GetCurrentTime();
+	Event.bDebugging = true;
+	EnqueueHeartbeat(Event);
+}
+
+void FWakatimeIntegrationModule::SampleUserActivity()
+{
+	// Slate already records when the user last pressed a key, clicked or moved the mouse over an
+	// editor window, including camera moves and graph browsing that never modify an object.
+	if (!FSlateApplication::IsInitialized()) {
+		return;
 	}
-	SendHeartbeat();
+
+	const double InteractionTime = FSlateApplication::Get().GetLastUserInteractionTime();
+	if (InteractionTime <= LastSeenInteractionTime) {
+		return;
+	}
+	LastSeenInteractionTime = InteractionTime;
+
+	const int64 WallTime = ClockOffset.load(std::memory_order_relaxed) + static_cast<int64>(InteractionTime);
+	if (WallTime > LastActivityTime.load(std::memory_order_relaxed)) {
+		LastActivityTime.store(WallTime, std::memory_order_relaxed);
+	}
+	Dirty.store(true, std::memory_order_release);
 }
 
-void FWakatimeIntegrationModule::OnObjectModified(UObject* ModifiedObject)
+void FWakatimeIntegrationModule::OnUserInteraction(double InteractionTime)
 {
+	// Fires for every input event; while the timer runs at its normal pace this is a single branch
+	if (!bTimerBackedOff) {
+		return;
+	}
+
+	INC_DWORD_STAT(STAT_WakatimeIntegration_TimerWakeups);
 	MarkActivity();
+	ScheduleTimerTick(0.0f);
 }
 
-FString GetCurrentOSName()
+void FWakatimeIntegrationModule::OnApplicationActivationChanged(bool bIsActive)
 {
-#if PLATFORM_WINDOWS
-	return TEXT("Windows");
-#elif PLATFORM_MAC
-	return TEXT("Mac");
-#elif PLATFORM_LINUX
-	return TEXT("Linux");
-#elif PLATFORM_IOS
-	return TEXT("iOS");
-#elif PLATFORM_ANDROID
-	return TEXT("Android");
-#else
-	return TEXT("Unknown");
-#endif
+	// Switching back to the editor is activity even before the first click
+	if (bIsActive) {
+		MarkActivity();
+		if (bTimerBackedOff) {
+			INC_DWORD_STAT(STAT_WakatimeIntegration_TimerWakeups);
+			ScheduleTimerTick(0.0f);
+		}
+	}
+}
+
+void FWakatimeIntegrationModule::ScheduleTimerTick(float Delay)
+{
+	if (TimerHandle.IsValid()) {
+		FTSTicker::GetCoreTicker().RemoveTicker(TimerHandle);
+	}
+	TimerDelay = Delay;
+	bTimerBackedOff = Delay > GetDefault<UWakatimeSettings>()->WakatimeInterval;
+	TimerHandle = FTSTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateRaw(this, &FWakatimeIntegrationModule::OnTimerTick),
+		Delay
+	);
 }
 
 bool FWakatimeIntegrationModule::OnTimerTick(float DeltaTime)
 {
+	// Measured under its stat but left out of the frame budget: this is housekeeping that runs every
+	// few seconds, and a slow store flush here shouldn't cost the next 300 frames of real events
+	WAKATIME_SCOPE(OnTimerTick);
+	SyncClock();
+	SampleUserActivity();
+	ConfigureFrameBudget();
+	ActivityStore.Tick();
 	int64 now = GetCurrentTime();
 	const UWakatimeSettings* Settings = GetDefault<UWakatimeSettings>();
 	if (!Settings) {
 		return true;
 	}
 
-	int64 activityTimeout = 120;
-	bool hasRecentActivity = false;
-	{
-		FScopeLock Lock(&DataLock);
-		hasRecentActivity = (now - LastActivityTime) < activityTimeout;
-		if (hasRecentActivity) {
-			Dirty = true;
+	if (bInPie) {
+		// Someone playing is someone debugging; report at the plain interval, no backing off
+		SendDebuggingHeartbeat();
+		Uploader.Tick();
+		const float Interval = Settings->WakatimeInterval;
+		if (TimerDelay != Interval) {
+			TimerHandle.Reset();
+			ScheduleTimerTick(Interval);
+			return false;
 		}
+		return true;
+	}
+
+	int64 activityTimeout = 120;
+	bool hasRecentActivity = (now - LastActivityTime.load(std::memory_order_relaxed)) < activityTimeout;
+	if (hasRecentActivity) {
+		Dirty.store(true, std::memory_order_release);
 	}
 
 	SendHeartbeat();
+
+	Uploader.Tick();
+
+	// Idle ticks have nothing to send, so each one doubles the wait; input resets it through
+	// OnUserInteraction without waiting for the timer.
+	const float Interval = Settings->WakatimeInterval;
+	const float NextDelay = hasRecentActivity ? Interval : FMath::Clamp(TimerDelay * 2.0f, Interval, FMath::Max(Interval, MaxIdleTimerDelay));
+	if (NextDelay != TimerDelay) {
+		TimerHandle.Reset();
+		ScheduleTimerTick(NextDelay);
+		return false;
+	}
 	return true;
 }
 
 void FWakatimeIntegrationModule::SendHeartbeat()
 {
-	FName localLastSavedName = TEXT("None");
-	int32 localDeleteOperations = 0;
-	int32 localSaveOperations = 0;
-	int32 localRenameOperations = 0;
-	int32 localAddOperations = 0;
-	bool localDirty = false;
+	TArray<FWakatimeHeartbeatEvent> Events;
+	BuildHeartbeats(Events);
+	for (const FWakatimeHeartbeatEvent& Event : Events)
 	{
-		FScopeLock Lock(&DataLock);
-		localDirty = Dirty;
-		if (!localDirty) {
-			return;
-		}
-		localDeleteOperations = DeleteOperations;
-		localSaveOperations = SaveOperations;
-		localRenameOperations = RenameOperations;
-		localAddOperations = AddOperations;
-		localLastSavedName = LastSavedName;
-
-		DeleteOperations = 0;
-		SaveOperations = 0;
-		RenameOperations = 0;
-		AddOperations = 0;
-		Dirty = false;
+		EnqueueHeartbeat(Event);
+	}
+}
+
+void FWakatimeIntegrationModule::EnqueueHeartbeat(const FWakatimeHeartbeatEvent& Event)
+{
+	if (!HeartbeatDedup.ShouldSend(Event)) {
+		return;
 	}
+	ActivityStore.Append(Event);
+	Uploader.Enqueue(Event);
+}
+
+void FWakatimeIntegrationModule::BuildHeartbeats(TArray<FWakatimeHeartbeatEvent>& OutEvents)
+{
+	bool localDirty = Dirty.exchange(false, std::memory_order_acquire);
 	if (!localDirty) {
 		return;
 	}
+
+	TArray<FWakatimeEntityActivity> Touched;
+	ActivityTable.Drain(Touched);
+	if (Touched.Num() == 0 && OverflowEntities == 0) {
+		// Recent activity that didn't touch any package still counts as time on the last one
+		FWakatimeEntityActivity& Entry = Touched.AddDefaulted_GetRef();
+		Entry.Package = LastEntity;
+		Entry.FirstTime = Entry.LastTime = GetCurrentTime();
+	}
+
+	// A bulk import touches thousands of packages; the busiest ones keep their own heartbeat and the
+	// rest share the last slot
+	const int32 MaxHeartbeats = FMath::Max(GetDefault<UWakatimeSettings>()->WakatimeMaxHeartbeatsPerFlush, 1);
+	if (Touched.Num() > MaxHeartbeats || (OverflowEntities > 0 && Touched.Num() >= MaxHeartbeats)) {
+		const int32 Keep = MaxHeartbeats - 1;
+		Touched.Sort([](const FWakatimeEntityActivity& A, const FWakatimeEntityActivity& B)
+		{
+			return A.NumEvents() != B.NumEvents() ? A.NumEvents() > B.NumEvents() : A.LastTime > B.LastTime;
+		});
+		for (int32 Index = Keep; Index < Touched.Num(); ++Index)
+		{
+			AddToOverflow(Touched[Index]);
+		}
+		Touched.SetNum(Keep);
+	}
+
+	for (const FWakatimeEntityActivity& Entry : Touched)
+	{
+		OutEvents.Add(MakeHeartbeatEvent(Entry));
+	}
+
+	if (OverflowEntities > 0) {
+		OverflowActivity.Package = OverflowFolder.IsEmpty() ? LastEntity : FName(*OverflowFolder);
+		OutEvents.Add(MakeHeartbeatEvent(OverflowActivity));
+		OverflowActivity = FWakatimeEntityActivity();
+		OverflowFolder.Reset();
+		OverflowEntities = 0;
+	}
+}
+
+FWakatimeHeartbeatEvent FWakatimeIntegrationModule::MakeHeartbeatEvent(const FWakatimeEntityActivity& Activity) const
+{
+	FWakatimeHeartbeatEvent Event;
+	Event.Entity = Activity.Package;
+	Event.Time = Activity.LastTime;
+	// The line count is optional, and while degraded it would be built from sampled counters; leaving it
+	// out also lets the dedup collapse the heartbeat like any other repeat
+	Event.Lines = FrameBudget.IsDegraded() ? 0 : Activity.Additions + Activity.Saves;
+	Event.bIsWrite = Activity.bIsWrite;
+	return Event;
+}
+
+bool FWakatimeIntegrationModule::OnStatsTick(float DeltaTime)
+{
+	WAKATIME_SCOPE(OnStatsTick);
+	FWakatimeFrameBudget::FScope BudgetScope(FrameBudget);
+	const int32 DayOfYear = FDateTime::Now().GetDayOfYear();
+	if (DayOfYear != StatsDayOfYear) {
+		// New day: yesterday's total and validators no longer apply
+		StatsDayOfYear = DayOfYear;
+		ServerTodaySeconds = 0.0;
+		LocalTodaySeconds = 0.0;
+		bHaveServerToday = false;
+		bStoreFallbackComputed = false;
+		StatsETag.Reset();
+		StatsLastModified.Reset();
+		NextStatsFetchTime = 0.0;
+	}
+
+	// Count the second locally if the user was active within the same window the heartbeats use
+	SampleUserActivity();
+	int64 activityTimeout = 120;
+	if (GetCurrentTime() - LastActivityTime.load(std::memory_order_relaxed) < activityTimeout) {
+		LocalTodaySeconds += DeltaTime;
+	}
+
+	// Followers take the total the leading editor fetched instead of asking the server themselves
+	double SharedTodaySeconds = 0.0;
+	const double Now = FPlatformTime::Seconds();
+	if (bCoordinatorActive && Coordinator.GetTodaySeconds(StatsDayOfYear, SharedTodaySeconds)) {
+		if (SharedTodaySeconds != ServerTodaySeconds) {
+			ServerTodaySeconds = SharedTodaySeconds;
+			LocalTodaySeconds = 0.0;
+		}
+		bHaveServerToday = true;
+	}
+	else if (Now >= NextStatsFetchTime && !StatsRequest.IsValid()) {
+		NextStatsFetchTime = Now + GetDefault<UWakatimeSettings>()->WakatimeStatsRefreshInterval;
+		FetchTodayStats();
+	}
+
+	UpdateTodayTimeText();
+	return true;
+}
+
+void FWakatimeIntegrationModule::FetchTodayStats()
+{
 	const UWakatimeSettings* Settings = GetDefault<UWakatimeSettings>();
-	if (!Settings) {
+
+	// WakaTime serves status_bar/today; some compatible servers only know the older statusbar spelling
+	FString Path = bStatsLegacyPath ? TEXT("/users/current/statusbar/today") : TEXT("/users/current/status_bar/today");
+
+	StatsRequest = FHttpModule::Get().CreateRequest();
+	StatsRequest->SetURL(Settings->GetApiBaseURL() + Path);
+	StatsRequest->SetVerb(TEXT("GET"));
+	StatsRequest->SetHeader(TEXT("Authorization"), Settings->GetAuthorizationHeader());
+	if (!StatsETag.IsEmpty()) {
+		StatsRequest->SetHeader(TEXT("If-None-Match"), StatsETag);
+	}
+	if (!StatsLastModified.IsEmpty()) {
+		StatsRequest->SetHeader(TEXT("If-Modified-Since"), StatsLastModified);
+	}
+	StatsRequest->OnProcessRequestComplete().BindRaw(this, &FWakatimeIntegrationModule::OnStatsHttpResponse);
+	StatsRequest->ProcessRequest();
+}
+
+void FWakatimeIntegrationModule::ComputeStoreFallback()
+{
+	// Decoding a month of blocks is too slow for the game thread. The buffered rows are copied instead
+	// of flushed, and the local seconds counted until now are taken off once the store total arrives.
+	const FString Directory = FWakatimeActivityStore::GetDefaultDirectory();
+	const FDateTime From = FWakatimeActivityStore::GetLocalDayStart(0);
+	const FDateTime To = FDateTime::UtcNow() + FTimespan::FromMinutes(1);
+	const int32 DayOfYear = StatsDayOfYear;
+	const double CountedLocally = LocalTodaySeconds;
+	TWeakPtr<bool, ESPMode::ThreadSafe> WeakAlive = AliveToken;
+	Async(EAsyncExecution::ThreadPool, [this, WeakAlive, Directory, From, To, DayOfYear, CountedLocally, Rows = ActivityStore.GetBufferedRows()]()
+	{
+		TArray<FWakatimeStoreTotal> Totals;
+		double StoreTodaySeconds = 0.0;
+		FWakatimeActivityStore::Query(Directory, From, To, EWakatimeStoreGrouping::Category, Rows, Totals, StoreTodaySeconds);
+
+		AsyncTask(ENamedThreads::GameThread, [this, WeakAlive, DayOfYear, CountedLocally, StoreTodaySeconds]()
+		{
+			// The server may have answered, or the day ended, while the query ran
+			if (!WeakAlive.IsValid() || bHaveServerToday || DayOfYear != StatsDayOfYear) {
+				return;
+			}
+			ServerTodaySeconds = StoreTodaySeconds;
+			LocalTodaySeconds = FMath::Max(LocalTodaySeconds - CountedLocally, 0.0);
+			UpdateTodayTimeText();
+		});
+	});
+}
+
+void FWakatimeIntegrationModule::OnStatsHttpResponse(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful)
+{
+	StatsRequest.Reset();
+
+	if (!bWasSuccessful || !Response.IsValid()) {
+		UE_LOG(LogTemp, Verbose, TEXT("Wakatime Integration: Could not fetch today's stats."));
+
+		// Offline before the server ever answered today: start from the local history instead of zero
+		if (!bHaveServerToday && !bStoreFallbackComputed) {
+			bStoreFallbackComputed = true;
+			ComputeStoreFallback();
+		}
 		return;
 	}
 
-	FString Endpoint = Settings->WakatimeEndpoint;
-	if (Endpoint.IsEmpty()) {
-		Endpoint = TEXT("https://api.wakatime.com/api/v1");
-		UE_LOG(LogTemp, Warning, TEXT("Wakatime Integration: No endpoint configured, using default Wakatime API"));
+	const int32 ResponseCode = Response->GetResponseCode();
+	if (ResponseCode == 304) {
+		// Nothing new on the server; keep adding local activity on top of the last total
+		return;
 	}
-	if (Endpoint.EndsWith(TEXT("/")))
-	{
-		Endpoint.RemoveAt(Endpoint.Len() - 1);
+	if (ResponseCode == 404 && !bStatsLegacyPath) {
+		bStatsLegacyPath = true;
+		NextStatsFetchTime = 0.0;
+		return;
+	}
+	if (ResponseCode < 200 || ResponseCode >= 300) {
+		UE_LOG(LogTemp, Warning, TEXT("Wakatime Integration: Today's stats request failed. Response code: %d"), ResponseCode);
+		return;
 	}
 
-	FString EntityName = TEXT("None");
-	if (localLastSavedName.IsValid())
+	// {"data": {"grand_total": {"total_seconds": 1234.5, ...}, ...}}
+	TSharedPtr<FJsonObject> Root;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Response->GetContentAsString());
+	const TSharedPtr<FJsonObject>* Data = nullptr;
+	const TSharedPtr<FJsonObject>* GrandTotal = nullptr;
+	double TotalSeconds = 0.0;
+	if (!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid()
+		|| !Root->TryGetObjectField(TEXT("data"), Data)
+		|| !(*Data)->TryGetObjectField(TEXT("grand_total"), GrandTotal)
+		|| !(*GrandTotal)->TryGetNumberField(TEXT("total_seconds"), TotalSeconds))
 	{
-		EntityName = localLastSavedName.ToString();
-	}
-	int64 localTime = GetCurrentTime();
-	FString EngineVersionString = FEngineVersion::Current().ToString(EVersionComponent::Patch);
-	FString ProjectName = FApp::GetProjectName();
-	FString ComputerName = FPlatformProcess::ComputerName();
-	FString OSName = GetCurrentOSName();
-
-	FString TargetURL = Endpoint + TEXT("/users/current/heartbeats");
-
-	FString Body = FString::Printf(
-		TEXT(
-			"{\"type\":\"file\",\"time\":%lld,\"project\":\"%s\",\"entity\":\"%s\","
-			"\"language\":\"UnrealEngine\",\"is_write\":%s,"
-			"\"editor\":\"Unreal Engine\",\"plugin\":\"unreal-wakatime/%s\","
-			"\"operating_system\":\"%s\",\"machine\":\"%s\","
-			"\"lines\":%d,\"lineno\":1,\"cursorpos\":0}"
-		),
-		localTime,
-		*ProjectName,
-		*EntityName,
-		(localSaveOperations > 0) ? TEXT("true") : TEXT("false"),
-		*EngineVersionString,
-		*OSName,
-		*ComputerName,
-		localAddOperations + localSaveOperations
-	);
+		UE_LOG(LogTemp, Warning, TEXT("Wakatime Integration: Unexpected today's stats response."));
+		return;
+	}
+
+	StatsETag = Response->GetHeader(TEXT("ETag"));
+	StatsLastModified = Response->GetHeader(TEXT("Last-Modified"));
+	ServerTodaySeconds = TotalSeconds;
+	LocalTodaySeconds = 0.0;
+	bHaveServerToday = true;
+	if (bCoordinatorActive) {
+		Coordinator.PublishTodaySeconds(ServerTodaySeconds, StatsDayOfYear);
+	}
+	UpdateTodayTimeText();
+}
+
+void FWakatimeIntegrationModule::UpdateTodayTimeText()
+{
+	if (StatsDayOfYear < 0) {
+		return;
+	}
 
-	TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = FHttpModule::Get().CreateRequest();
-	Request->SetURL(TargetURL);
-	Request->SetVerb(TEXT("POST"));
-	Request->SetHeader(TEXT("Content-Type"), TEXT("application/json"));
-	Request->SetHeader(TEXT("User-Agent"), FString::Printf(TEXT("unreal-wakatime/%s"), *EngineVersionString));
+	// Only rebuild the text when the displayed value changes; Slate reads the cached FText every paint
+	const int32 Minutes = FMath::FloorToInt32((ServerTodaySeconds + LocalTodaySeconds) / 60.0);
+	if (Minutes == DisplayedMinutes) {
+		return;
+	}
+	DisplayedMinutes = Minutes;
+	TodayTimeFormatted = FText::FromString(FString::Printf(TEXT("%d:%02d"), Minutes / 60, Minutes % 60));
+}
 
-	FString RawBearerToken = Settings->WakatimeBearerToken.TrimStartAndEnd();
-	FString AuthToken = FString::Printf(TEXT("Bearer %s"), *RawBearerToken);
-	Request->SetHeader(TEXT("Authorization"), AuthToken);
+FText FWakatimeIntegrationModule::GetTodayTimeText() const
+{
+	return TodayTimeFormatted;
+}
 
-	Request->SetContentAsString(Body);
+void FWakatimeIntegrationModule::RegisterToolbarExtension()
+{
+	FToolMenuOwnerScoped OwnerScoped(this);
 
-	Request->OnProcessRequestComplete().BindRaw(this, &FWakatimeIntegrationModule::OnHttpResponse);
+	UToolMenu* ToolbarMenu = UToolMenus::Get()->ExtendMenu("LevelEditor.LevelEditorToolBar.User");
+	FToolMenuSection& Section = ToolbarMenu->FindOrAddSection("Wakatime");
+	Section.AddEntry(FToolMenuEntry::InitWidget("WakatimeTodayTime", GenerateToolbarWidget(), FText::GetEmpty(), true));
+}
 
-	Request->ProcessRequest();
+TSharedRef<SWidget> FWakatimeIntegrationModule::GenerateToolbarWidget()
+{
+	return SNew(SBox)
+		.VAlign(VAlign_Center)
+		.Padding(FMargin(6.0f, 0.0f))
+		[
+			SNew(STextBlock)
+			.Text_Raw(this, &FWakatimeIntegrationModule::GetTodayTimeText)
+			.ToolTipText(LOCTEXT("TodayTimeTooltip", "Time tracked today"))
+		];
 }
 
 int64 FWakatimeIntegrationModule::GetCurrentTime()
+{
+	// Wall-clock seconds derived from the monotonic platform timer. The offset to the system clock
+	// is captured by SyncClock, so the hot path never has to go through std::chrono::system_clock.
+	return ClockOffset.load(std::memory_order_relaxed) + static_cast<int64>(FPlatformTime::Seconds());
+}
+
+void FWakatimeIntegrationModule::SyncClock()
 {
 	std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
 	std::chrono::system_clock::duration duration = now.time_since_epoch();
 	std::chrono::seconds seconds_duration = std::chrono::duration_cast<std::chrono::seconds>(duration);
 	int64_t seconds_since_epoch = seconds_duration.count();
-	return seconds_since_epoch;
+	ClockOffset.store(seconds_since_epoch - static_cast<int64>(FPlatformTime::Seconds()), std::memory_order_relaxed);
 }
 
-void FWakatimeIntegrationModule::OnHttpResponse(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful)
+void FWakatimeIntegrationModule::BenchmarkActivity(const TArray<FString>& Args)
 {
-	if (!bWasSuccessful || !Response.IsValid())
+	const int32 Iterations = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 1000000;
+
+	// The ingestion path as it was before the counters became atomics: a critical section
+	// plus a system_clock query on every call.
+	FCriticalSection BaselineLock;
+	bool BaselineDirty = false;
+	int64 BaselineLastActivity = 0;
+	auto BaselineMarkActivity = [&]()
 	{
-		UE_LOG(LogTemp, Error, TEXT("Wakatime Integration: Failed to establish connection to endpoint."));
-		return;
+		std::chrono::seconds seconds_duration = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch());
+		int64 now = seconds_duration.count();
+		FScopeLock Lock(&BaselineLock);
+		BaselineDirty = true;
+		BaselineLastActivity = now;
+	};
+
+	const bool bWasDirty = Dirty.load();
+	const int64 PreviousActivity = LastActivityTime.load();
+
+	double Start = FPlatformTime::Seconds();
+	for (int32 Index = 0; Index < Iterations; ++Index)
+	{
+		BaselineMarkActivity();
 	}
+	const double BaselineNs = (FPlatformTime::Seconds() - Start) * 1e9 / Iterations;
 
-	int32 ResponseCode = Response->GetResponseCode();
-	FString ResponseString = Response->GetContentAsString();
-
-	if (ResponseCode >= 200 && ResponseCode < 300) {
-		UE_LOG(LogTemp, Log, TEXT("Wakatime Integration: Heartbeat accepted with code %d"), ResponseCode);
-	}
-	else if (ResponseCode == 401)
+	Start = FPlatformTime::Seconds();
+	for (int32 Index = 0; Index < Iterations; ++Index)
 	{
-		UE_LOG(LogTemp, Error, TEXT("Wakatime Integration: Heartbeat failed due to invalid API token (401). Response: %s"), *ResponseString);
+		MarkActivity();
 	}
-	else
-	{
-		UE_LOG(LogTemp, Error, TEXT("Wakatime Integration: Heartbeat failed. Code: %d. Response: %s"), ResponseCode, *ResponseString);
+	const double CurrentNs = (FPlatformTime::Seconds() - Start) * 1e9 / Iterations;
+
+	// The benchmark must not count as user activity
+	Dirty.store(bWasDirty);
+	LastActivityTime.store(PreviousActivity);
+
+	UE_LOG(LogTemp, Display, TEXT("Wakatime Integration: MarkActivity x%d - locked baseline %.1f ns/call, atomic %.1f ns/call (%.1fx)"),
+		Iterations, BaselineNs, CurrentNs, CurrentNs > 0.0 ? BaselineNs / CurrentNs : 0.0);
+}
+
+void FWakatimeIntegrationModule::ReportActivity(const TArray<FString>& Args)
+{
+	const int32 Days = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 1;
+	EWakatimeStoreGrouping Grouping = EWakatimeStoreGrouping::Entity;
+	if (Args.Num() > 1 && !FWakatimeActivityStore::ParseGrouping(Args[1], Grouping)) {
+		UE_LOG(LogTemp, Warning, TEXT("Wakatime Integration: Unknown grouping '%s', expected asset, folder or category"), *Args[1]);
+		return;
+	}
+	const int32 Top = Args.Num() > 2 ? FCString::Atoi(*Args[2]) : 20;
+
+	ActivityStore.Flush();
+	const double Start = FPlatformTime::Seconds();
+	TArray<FWakatimeStoreTotal> Totals;
+	double TotalSeconds = 0.0;
+	const bool bFound = FWakatimeActivityStore::Query(FWakatimeActivityStore::GetDefaultDirectory(), FWakatimeActivityStore::GetLocalDayStart(Days - 1),
+		FDateTime::UtcNow() + FTimespan::FromMinutes(1), Grouping, Totals, TotalSeconds);
+	const double QueryMs = (FPlatformTime::Seconds() - Start) * 1000.0;
+
+	if (!bFound) {
+		UE_LOG(LogTemp, Display, TEXT("Wakatime Integration: No local activity in the last %d day(s)"), Days);
+		return;
 	}
+	UE_LOG(LogTemp, Display, TEXT("Wakatime Integration: Local activity for the last %d day(s) (%.1f ms)"), Days, QueryMs);
+	FWakatimeActivityStore::LogReport(Totals, TotalSeconds, Top);
 }
 
 #undef LOCTEXT_NAMESPACE
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "WakatimeReportCommandlet.h"
+#include "WakatimeActivityStore.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+
+UWakatimeReportCommandlet::UWakatimeReportCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UWakatimeReportCommandlet::Main(const FString& Params)
+{
+	int32 Days = 1;
+	int32 Top = 20;
+	int64 TimeoutSeconds = 15 * 60;
+	FString GroupBy = TEXT("asset");
+	FString StoreDirectory = FWakatimeActivityStore::GetDefaultDirectory();
+	FString FromText;
+	FString ToText;
+	FString OutputPath;
+
+	FParse::Value(*Params, TEXT("Days="), Days);
+	FParse::Value(*Params, TEXT("Top="), Top);
+	FParse::Value(*Params, TEXT("Timeout="), TimeoutSeconds);
+	FParse::Value(*Params, TEXT("GroupBy="), GroupBy);
+	FParse::Value(*Params, TEXT("Store="), StoreDirectory);
+	FParse::Value(*Params, TEXT("From="), FromText);
+	FParse::Value(*Params, TEXT("To="), ToText);
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+
+	EWakatimeStoreGrouping Grouping;
+	if (!FWakatimeActivityStore::ParseGrouping(GroupBy, Grouping)) {
+		UE_LOG(LogTemp, Error, TEXT("Wakatime Integration: Unknown -GroupBy=%s, expected asset, folder or category"), *GroupBy);
+		return 1;
+	}
+
+	FDateTime From = FWakatimeActivityStore::GetLocalDayStart(FMath::Max(Days, 1) - 1);
+	FDateTime To = FDateTime::UtcNow() + FTimespan::FromMinutes(1);
+	if ((!FromText.IsEmpty() && !FDateTime::ParseIso8601(*FromText, From))
+		|| (!ToText.IsEmpty() && !FDateTime::ParseIso8601(*ToText, To)))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Wakatime Integration: -From and -To must be ISO 8601 dates or times, e.g. 2025-03-01 or 2025-03-01T09:00:00Z"));
+		return 1;
+	}
+
+	const double Start = FPlatformTime::Seconds();
+	TArray<FWakatimeStoreTotal> Totals;
+	double TotalSeconds = 0.0;
+	const bool bFound = FWakatimeActivityStore::Query(StoreDirectory, From, To, Grouping, Totals, TotalSeconds, TimeoutSeconds);
+	const double QueryMs = (FPlatformTime::Seconds() - Start) * 1000.0;
+
+	UE_LOG(LogTemp, Display, TEXT("Wakatime Integration: Activity from %s to %s UTC in %s (%.1f ms)"),
+		*From.ToIso8601(), *To.ToIso8601(), *StoreDirectory, QueryMs);
+	if (!bFound) {
+		UE_LOG(LogTemp, Display, TEXT("Wakatime Integration: No activity recorded in that range"));
+		return 0;
+	}
+	FWakatimeActivityStore::LogReport(Totals, TotalSeconds, Top);
+
+	if (OutputPath.IsEmpty()) {
+		return 0;
+	}
+
+	FString Csv = TEXT("key,seconds,heartbeats\n");
+	for (const FWakatimeStoreTotal& Total : Totals)
+	{
+		Csv += FString::Printf(TEXT("\"%s\",%.0f,%d\n"), *Total.Key.Replace(TEXT("\""), TEXT("\"\"")), Total.Seconds, Total.Heartbeats);
+	}
+	const bool bSaved = FFileHelper::SaveStringToFile(Csv, *OutputPath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM);
+	UE_LOG(LogTemp, Display, TEXT("Wakatime Integration: Report %s %s"), bSaved ? TEXT("written to") : TEXT("could not be written to"), *OutputPath);
+	return bSaved ? 0 : 1;
+}
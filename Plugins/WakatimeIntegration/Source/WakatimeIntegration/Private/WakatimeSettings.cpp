@@ -5,4 +5,35 @@ UWakatimeSettings::UWakatimeSettings()
 	WakatimeBearerToken = TEXT("XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX");
 	WakatimeInterval = 60;
 	WakatimeEndpoint = TEXT("https://wakatime.com/api/v1");
+	WakatimeSpoolSizeMB = 64;
+	WakatimeBatchWindow = 10;
+	WakatimeMaxBatchSize = 25;
+	WakatimeMaxInFlight = 2;
+	WakatimeEventFlushRate = 6.0f;
+	WakatimeEventFlushBurst = 3;
+	WakatimeMaxHeartbeatsPerFlush = 16;
+	WakatimeStatsRefreshInterval = 300;
+	bWakatimeShareUploads = true;
+	WakatimeFrameBudgetMicroseconds = 50.0f;
+	WakatimeDegradedSampleRate = 8;
+}
+
+FString UWakatimeSettings::GetApiBaseURL() const
+{
+	FString Endpoint = WakatimeEndpoint;
+	if (Endpoint.IsEmpty()) {
+		Endpoint = TEXT("https://api.wakatime.com/api/v1");
+		UE_LOG(LogTemp, Warning, TEXT("Wakatime Integration: No endpoint configured, using default Wakatime API"));
+	}
+	if (Endpoint.EndsWith(TEXT("/")))
+	{
+		Endpoint.RemoveAt(Endpoint.Len() - 1);
+	}
+	return Endpoint;
+}
+
+FString UWakatimeSettings::GetAuthorizationHeader() const
+{
+	FString RawBearerToken = WakatimeBearerToken.TrimStartAndEnd();
+	return FString::Printf(TEXT("Bearer %s"), *RawBearerToken);
 }
\ No newline at end of file
@@ -0,0 +1,310 @@
+#include "WakatimeSpool.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/Crc.h"
+#include "Misc/ScopeLock.h"
+
+namespace WakatimeSpool
+{
+	static const TCHAR* SegmentPrefix = TEXT("spool-");
+	static const TCHAR* LogExtension = TEXT(".log");
+	static const TCHAR* ReplayExtension = TEXT(".replay");
+	static const int64 MinSegmentBytes = 64 * 1024;
+	static const int64 MaxSegmentBytes = 4 * 1024 * 1024;
+
+	struct FFoundSegment
+	{
+		FString FileName;
+		uint32 ProcessId = 0;
+		int32 Sequence = INDEX_NONE;
+		FDateTime TimeStamp;
+	};
+
+	/** "spool-<pid>-<sequence>"; segments written before the pid was part of the name have no owner (0). */
+	static bool ParseSegmentName(const FString& FileName, uint32& OutProcessId, int32& OutSequence)
+	{
+		FString BaseName = FPaths::GetBaseFilename(FileName);
+		if (!BaseName.RemoveFromStart(SegmentPrefix)) {
+			return false;
+		}
+		FString ProcessText;
+		FString SequenceText;
+		if (!BaseName.Split(TEXT("-"), &ProcessText, &SequenceText)) {
+			ProcessText = TEXT("0");
+			SequenceText = BaseName;
+		}
+		if (!ProcessText.IsNumeric() || !SequenceText.IsNumeric()) {
+			return false;
+		}
+		OutProcessId = static_cast<uint32>(FCString::Strtoui64(*ProcessText, nullptr, 10));
+		OutSequence = FCString::Atoi(*SequenceText);
+		return true;
+	}
+}
+
+FWakatimeSpool::~FWakatimeSpool()
+{
+	Shutdown();
+}
+
+void FWakatimeSpool::Initialize(const FString& InDirectory, int64 InMaxBytes)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	Directory = InDirectory;
+	MaxBytes = FMath::Max<int64>(InMaxBytes, WakatimeSpool::MinSegmentBytes * 2);
+	SegmentBytes = FMath::Clamp<int64>(MaxBytes / 16, WakatimeSpool::MinSegmentBytes, WakatimeSpool::MaxSegmentBytes);
+	TotalBytes = 0;
+	PendingSegments.Reset();
+	SegmentSizes.Reset();
+	NextSequence = 1;
+	ProcessId = FPlatformProcess::GetCurrentProcessId();
+
+	IFileManager::Get().MakeDirectory(*Directory, true);
+	AdoptSegments();
+
+	if (PendingSegments.Num() > 0) {
+		UE_LOG(LogTemp, Log, TEXT("Wakatime Integration: Found %d spooled segment(s) (%lld bytes) from a previous session"), PendingSegments.Num(), TotalBytes);
+	}
+	EnforceBudget();
+}
+
+void FWakatimeSpool::AdoptSegments()
+{
+	IFileManager& FileManager = IFileManager::Get();
+
+	TArray<WakatimeSpool::FFoundSegment> Found;
+	for (const TCHAR* Extension : { WakatimeSpool::LogExtension, WakatimeSpool::ReplayExtension })
+	{
+		TArray<FString> Files;
+		FileManager.FindFiles(Files, *(Directory / (FString(TEXT("*")) + Extension)), true, false);
+		for (const FString& File : Files)
+		{
+			WakatimeSpool::FFoundSegment Segment;
+			if (!WakatimeSpool::ParseSegmentName(File, Segment.ProcessId, Segment.Sequence)) {
+				continue;
+			}
+			// Another editor on this project is still writing or replaying it. Our own id can only
+			// be left over from an earlier process that had the same id, so that is fair game.
+			if (Segment.ProcessId != 0 && Segment.ProcessId != ProcessId && FPlatformProcess::IsApplicationRunning(Segment.ProcessId)) {
+				continue;
+			}
+			Segment.FileName = File;
+			Segment.TimeStamp = FileManager.GetTimeStamp(*(Directory / File));
+			if (Segment.ProcessId == ProcessId) {
+				NextSequence = FMath::Max(NextSequence, Segment.Sequence + 1);
+			}
+			Found.Add(MoveTemp(Segment));
+		}
+	}
+
+	Found.Sort([](const WakatimeSpool::FFoundSegment& A, const WakatimeSpool::FFoundSegment& B)
+	{
+		return A.TimeStamp == B.TimeStamp ? A.Sequence < B.Sequence : A.TimeStamp < B.TimeStamp;
+	});
+
+	// Records in an adopted segment were never confirmed, replaying or not, so each one is
+	// renamed into this process' queue. The rename is also the claim: if another editor
+	// starting at the same time got there first, the move fails and the segment is theirs.
+	for (const WakatimeSpool::FFoundSegment& Segment : Found)
+	{
+		const FString From = Directory / Segment.FileName;
+		const int64 Size = FileManager.FileSize(*From);
+		if (Size <= 0) {
+			FileManager.Delete(*From);
+			continue;
+		}
+
+		const int32 Sequence = Segment.ProcessId == ProcessId ? Segment.Sequence : NextSequence++;
+		const FString To = MakeSegmentPath(Sequence, WakatimeSpool::LogExtension);
+		if (From != To && !FileManager.Move(*To, *From, false)) {
+			continue;
+		}
+		PendingSegments.Add(Sequence);
+		SegmentSizes.Add(Sequence, Size);
+		TotalBytes += Size;
+	}
+}
+
+void FWakatimeSpool::Shutdown()
+{
+	FScopeLock ScopeLock(&Lock);
+	CloseActiveSegment();
+}
+
+void FWakatimeSpool::Append(const FString& Heartbeat)
+{
+	Append(TArray<FString>{ Heartbeat });
+}
+
+void FWakatimeSpool::Append(const TArray<FString>& Heartbeats)
+{
+	if (Heartbeats.Num() == 0) {
+		return;
+	}
+
+	TArray<uint8> Buffer;
+	for (const FString& Heartbeat : Heartbeats)
+	{
+		FTCHARToUTF8 Utf8(*Heartbeat);
+		const uint32 Crc = FCrc::MemCrc32(Utf8.Get(), Utf8.Length());
+		ANSICHAR Prefix[16];
+		const int32 PrefixLen = FCStringAnsi::Snprintf(Prefix, UE_ARRAY_COUNT(Prefix), "%08x ", Crc);
+		Buffer.Append(reinterpret_cast<const uint8*>(Prefix), PrefixLen);
+		Buffer.Append(reinterpret_cast<const uint8*>(Utf8.Get()), Utf8.Length());
+		Buffer.Add('\n');
+	}
+
+	FScopeLock ScopeLock(&Lock);
+	if (!ActiveHandle && !OpenActiveSegment()) {
+		UE_LOG(LogTemp, Error, TEXT("Wakatime Integration: Could not open spool segment in %s, %d heartbeat(s) lost"), *Directory, Heartbeats.Num());
+		return;
+	}
+
+	if (!ActiveHandle->Write(Buffer.GetData(), Buffer.Num())) {
+		UE_LOG(LogTemp, Error, TEXT("Wakatime Integration: Failed to write to spool, %d heartbeat(s) lost"), Heartbeats.Num());
+		CloseActiveSegment();
+		return;
+	}
+	ActiveHandle->Flush();
+	ActiveBytes += Buffer.Num();
+	TotalBytes += Buffer.Num();
+
+	if (ActiveBytes >= SegmentBytes) {
+		CloseActiveSegment();
+	}
+	EnforceBudget();
+}
+
+bool FWakatimeSpool::HasPending() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return PendingSegments.Num() > 0 || ActiveBytes > 0;
+}
+
+bool FWakatimeSpool::ClaimSegment(FString& OutSegment, TArray<FString>& OutHeartbeats)
+{
+	{
+		FScopeLock ScopeLock(&Lock);
+		if (PendingSegments.Num() == 0 && ActiveBytes > 0) {
+			CloseActiveSegment();
+		}
+		if (PendingSegments.Num() == 0) {
+			return false;
+		}
+
+		const int32 Sequence = PendingSegments[0];
+		PendingSegments.RemoveAt(0);
+		SegmentSizes.Remove(Sequence);
+
+		const FString LogPath = MakeSegmentPath(Sequence, WakatimeSpool::LogExtension);
+		OutSegment = MakeSegmentPath(Sequence, WakatimeSpool::ReplayExtension);
+		if (!IFileManager::Get().Move(*OutSegment, *LogPath, true)) {
+			OutSegment = LogPath;
+		}
+	}
+
+	ReadRecords(OutSegment, OutHeartbeats);
+	return true;
+}
+
+void FWakatimeSpool::ReleaseSegment(const FString& Segment)
+{
+	FScopeLock ScopeLock(&Lock);
+	const int64 Size = IFileManager::Get().FileSize(*Segment);
+	IFileManager::Get().Delete(*Segment);
+	if (Size > 0) {
+		TotalBytes = FMath::Max<int64>(TotalBytes - Size, 0);
+	}
+}
+
+FString FWakatimeSpool::MakeSegmentPath(int32 Sequence, const TCHAR* Extension) const
+{
+	return Directory / FString::Printf(TEXT("%s%u-%08d%s"), WakatimeSpool::SegmentPrefix, ProcessId, Sequence, Extension);
+}
+
+bool FWakatimeSpool::OpenActiveSegment()
+{
+	ActiveSequence = NextSequence++;
+	ActiveBytes = 0;
+	ActiveHandle = FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*MakeSegmentPath(ActiveSequence, WakatimeSpool::LogExtension), true);
+	return ActiveHandle != nullptr;
+}
+
+void FWakatimeSpool::CloseActiveSegment()
+{
+	if (ActiveHandle) {
+		delete ActiveHandle;
+		ActiveHandle = nullptr;
+	}
+	if (ActiveBytes > 0) {
+		PendingSegments.Add(ActiveSequence);
+		SegmentSizes.Add(ActiveSequence, ActiveBytes);
+	}
+	ActiveBytes = 0;
+}
+
+void FWakatimeSpool::EnforceBudget()
+{
+	while (TotalBytes > MaxBytes && PendingSegments.Num() > 0)
+	{
+		const int32 Sequence = PendingSegments[0];
+		PendingSegments.RemoveAt(0);
+		const int64 Size = SegmentSizes.FindAndRemoveChecked(Sequence);
+		IFileManager::Get().Delete(*MakeSegmentPath(Sequence, WakatimeSpool::LogExtension));
+		TotalBytes -= Size;
+		UE_LOG(LogTemp, Warning, TEXT("Wakatime Integration: Spool exceeded %lld bytes, dropped oldest segment (%lld bytes)"), MaxBytes, Size);
+	}
+}
+
+void FWakatimeSpool::ReadRecords(const FString& Path, TArray<FString>& OutHeartbeats)
+{
+	TArray<uint8> Data;
+	if (!FFileHelper::LoadFileToArray(Data, *Path)) {
+		return;
+	}
+
+	int32 LineStart = 0;
+	int32 Skipped = 0;
+	for (int32 Index = 0; Index < Data.Num(); ++Index)
+	{
+		if (Data[Index] != '\n') {
+			continue;
+		}
+		const int32 LineLen = Index - LineStart;
+		const uint8* Line = Data.GetData() + LineStart;
+		LineStart = Index + 1;
+
+		// "xxxxxxxx " followed by at least one byte of payload
+		if (LineLen < 10 || Line[8] != ' ') {
+			++Skipped;
+			continue;
+		}
+		ANSICHAR CrcText[9];
+		FMemory::Memcpy(CrcText, Line, 8);
+		CrcText[8] = '\0';
+		const uint32 ExpectedCrc = static_cast<uint32>(FCStringAnsi::Strtoui64(CrcText, nullptr, 16));
+
+		const uint8* Payload = Line + 9;
+		const int32 PayloadLen = LineLen - 9;
+		if (FCrc::MemCrc32(Payload, PayloadLen) != ExpectedCrc) {
+			++Skipped;
+			continue;
+		}
+
+		FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(Payload), PayloadLen);
+		OutHeartbeats.Emplace(Converted.Length(), Converted.Get());
+	}
+
+	// Anything after the last newline is a record that was being written when the process died.
+	if (LineStart < Data.Num()) {
+		++Skipped;
+	}
+	if (Skipped > 0) {
+		UE_LOG(LogTemp, Warning, TEXT("Wakatime Integration: Skipped %d damaged record(s) in %s"), Skipped, *Path);
+	}
+}
@@ -0,0 +1,223 @@
+#include "WakatimeStandInServer.h"
+#include "HttpServerModule.h"
+#include "IHttpRouter.h"
+#include "HttpServerRequest.h"
+#include "HttpServerResponse.h"
+#include "HttpPath.h"
+#include "Dom/JsonObject.h"
+#include "Dom/JsonValue.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+FWakatimeStandInServer::~FWakatimeStandInServer()
+{
+	Stop();
+}
+
+bool FWakatimeStandInServer::Start(uint32 InPort, const FWakatimeStandInFaults& InFaults)
+{
+	Port = InPort;
+	Faults = InFaults;
+
+	Router = FHttpServerModule::Get().GetHttpRouter(Port, /*bFailOnBindFailure*/ true);
+	if (!Router.IsValid()) {
+		UE_LOG(LogTemp, Error, TEXT("Wakatime Integration: Stand-in server could not bind port %u"), Port);
+		return false;
+	}
+
+	Routes.Add(Router->BindRoute(FHttpPath(TEXT("/api/v1/users/current/heartbeats")), EHttpServerRequestVerbs::VERB_POST,
+		FHttpRequestHandler::CreateRaw(this, &FWakatimeStandInServer::HandleHeartbeats)));
+	Routes.Add(Router->BindRoute(FHttpPath(TEXT("/api/v1/users/current/heartbeats.bulk")), EHttpServerRequestVerbs::VERB_POST,
+		FHttpRequestHandler::CreateRaw(this, &FWakatimeStandInServer::HandleHeartbeats)));
+	Routes.Add(Router->BindRoute(FHttpPath(TEXT("/api/v1/users/current/status_bar/today")), EHttpServerRequestVerbs::VERB_GET,
+		FHttpRequestHandler::CreateRaw(this, &FWakatimeStandInServer::HandleStats)));
+
+	TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FWakatimeStandInServer::OnTick));
+	FHttpServerModule::Get().StartAllListeners();
+	return true;
+}
+
+void FWakatimeStandInServer::Stop()
+{
+	if (TickHandle.IsValid()) {
+		FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+		TickHandle.Reset();
+	}
+	if (Router.IsValid()) {
+		for (const FHttpRouteHandle& Route : Routes)
+		{
+			Router->UnbindRoute(Route);
+		}
+		Routes.Empty();
+		Router.Reset();
+		FHttpServerModule::Get().StopAllListeners();
+	}
+	Delayed.Empty();
+	Dropped.Empty();
+	DroppedEntities.Empty();
+}
+
+FString FWakatimeStandInServer::GetEndpoint() const
+{
+	return FString::Printf(TEXT("http://127.0.0.1:%u/api/v1"), Port);
+}
+
+bool FWakatimeStandInServer::HandleHeartbeats(const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete)
+{
+	++Requests;
+	PayloadBytes += Request.Body.Num();
+
+	FUTF8ToTCHAR Converter(reinterpret_cast<const ANSICHAR*>(Request.Body.GetData()), Request.Body.Num());
+	FString Body(Converter.Length(), Converter.Get());
+
+	TArray<TSharedPtr<FJsonValue>> Items;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Body);
+	TSharedPtr<FJsonValue> Root;
+	if (FJsonSerializer::Deserialize(Reader, Root) && Root.IsValid()) {
+		if (Root->Type == EJson::Array) {
+			Items = Root->AsArray();
+		}
+		else {
+			Items.Add(Root);
+		}
+	}
+
+	TArray<FString> Entities;
+	for (const TSharedPtr<FJsonValue>& Item : Items)
+	{
+		FString& Entity = Entities.AddDefaulted_GetRef();
+		const TSharedPtr<FJsonObject>* Object = nullptr;
+		if (Item->TryGetObject(Object)) {
+			(*Object)->TryGetStringField(TEXT("entity"), Entity);
+		}
+	}
+
+	// Faults are drawn before anything is recorded, except for drops: those model a response lost on
+	// the way back, so the heartbeats did arrive and a retry shows up as a duplicate.
+	const bool bDrop = FMath::FRand() < Faults.DropRate;
+	EHttpServerResponseCodes Fault = EHttpServerResponseCodes::Ok;
+	if (!bDrop && InjectFault(OnComplete, &Fault)) {
+		if (Fault == EHttpServerResponseCodes::Denied) {
+			Rejected401.Append(Entities.FilterByPredicate([](const FString& Entity) { return !Entity.IsEmpty(); }));
+		}
+		return true;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	FString ResponseBody = TEXT("{\"responses\":[");
+	for (int32 Index = 0; Index < Entities.Num(); ++Index)
+	{
+		++HeartbeatsReceived;
+		const FString& Entity = Entities[Index];
+		if (!Entity.IsEmpty()) {
+			if (FirstSeen.Contains(Entity)) {
+				++Duplicates;
+				if (DroppedEntities.Contains(Entity)) {
+					++DuplicatesFromDrops;
+				}
+			}
+			else {
+				FirstSeen.Add(Entity, Now);
+			}
+		}
+		ResponseBody += Index > 0 ? TEXT(",[{},201]") : TEXT("[{},201]");
+	}
+	ResponseBody += TEXT("]}");
+
+	if (bDrop) {
+		DroppedEntities.Append(Entities);
+		Dropped.Add(OnComplete);
+		return true;
+	}
+
+	TUniquePtr<FHttpServerResponse> Response = FHttpServerResponse::Create(ResponseBody, TEXT("application/json"));
+	Response->Code = EHttpServerResponseCodes::Accepted;
+	Respond(MoveTemp(Response), OnComplete);
+	return true;
+}
+
+bool FWakatimeStandInServer::HandleStats(const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete)
+{
+	++StatsRequests;
+	if (InjectFault(OnComplete)) {
+		return true;
+	}
+
+	// The total only changes when heartbeats arrive, so the count doubles as the entity tag
+	const FString ETag = FString::Printf(TEXT("\"%d\""), HeartbeatsReceived);
+	const TArray<FString>* IfNoneMatch = Request.Headers.Find(TEXT("If-None-Match"));
+	if (IfNoneMatch && IfNoneMatch->Contains(ETag)) {
+		++StatsNotModified;
+		TUniquePtr<FHttpServerResponse> Response = FHttpServerResponse::Create(FString(), TEXT("application/json"));
+		Response->Code = EHttpServerResponseCodes::NotModified;
+		Respond(MoveTemp(Response), OnComplete);
+		return true;
+	}
+
+	FString Body = FString::Printf(TEXT("{\"data\":{\"grand_total\":{\"total_seconds\":%d}}}"), HeartbeatsReceived * 60);
+	TUniquePtr<FHttpServerResponse> Response = FHttpServerResponse::Create(Body, TEXT("application/json"));
+	Response->Headers.Add(TEXT("ETag"), { ETag });
+	Respond(MoveTemp(Response), OnComplete);
+	return true;
+}
+
+bool FWakatimeStandInServer::InjectFault(const FHttpResultCallback& OnComplete, EHttpServerResponseCodes* OutCode)
+{
+	EHttpServerResponseCodes Code = EHttpServerResponseCodes::Ok;
+	const float Roll = FMath::FRand();
+	if (Roll < Faults.Rate401) {
+		Code = EHttpServerResponseCodes::Denied;
+	}
+	else if (Roll < Faults.Rate401 + Faults.Rate429) {
+		Code = EHttpServerResponseCodes::TooManyRequests;
+	}
+	else if (Roll < Faults.Rate401 + Faults.Rate429 + Faults.Rate500) {
+		Code = EHttpServerResponseCodes::ServerError;
+	}
+	else {
+		return false;
+	}
+
+	if (OutCode) {
+		*OutCode = Code;
+	}
+	TUniquePtr<FHttpServerResponse> Response = FHttpServerResponse::Create(TEXT("{\"error\":\"injected\"}"), TEXT("application/json"));
+	Response->Code = Code;
+	if (Code == EHttpServerResponseCodes::TooManyRequests) {
+		Response->Headers.Add(TEXT("Retry-After"), { FString::FromInt(Faults.RetryAfterSeconds) });
+	}
+	Respond(MoveTemp(Response), OnComplete);
+	return true;
+}
+
+void FWakatimeStandInServer::Respond(TUniquePtr<FHttpServerResponse> Response, const FHttpResultCallback& OnComplete)
+{
+	ResponseCodes.FindOrAdd(static_cast<int32>(Response->Code))++;
+
+	if (Faults.LatencyMs <= 0.0f) {
+		OnComplete(MoveTemp(Response));
+		return;
+	}
+
+	FDelayedResponse& Entry = Delayed.AddDefaulted_GetRef();
+	Entry.ReadyTime = FPlatformTime::Seconds() + Faults.LatencyMs / 1000.0;
+	Entry.Response = MoveTemp(Response);
+	Entry.OnComplete = OnComplete;
+}
+
+bool FWakatimeStandInServer::OnTick(float DeltaTime)
+{
+	const double Now = FPlatformTime::Seconds();
+	for (int32 Index = 0; Index < Delayed.Num();)
+	{
+		if (Delayed[Index].ReadyTime <= Now) {
+			FDelayedResponse Entry = MoveTemp(Delayed[Index]);
+			Delayed.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+			Entry.OnComplete(MoveTemp(Entry.Response));
+		}
+		else {
+			++Index;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,63 @@
+#include "WakatimeStats.h"
+
+UE_TRACE_CHANNEL_DEFINE(WakatimeIntegrationChannel)
+
+DEFINE_STAT(STAT_WakatimeIntegration_OnAssetAdded);
+DEFINE_STAT(STAT_WakatimeIntegration_OnAssetRemoved);
+DEFINE_STAT(STAT_WakatimeIntegration_OnAssetRenamed);
+DEFINE_STAT(STAT_WakatimeIntegration_OnObjectSaved);
+DEFINE_STAT(STAT_WakatimeIntegration_OnTransaction);
+DEFINE_STAT(STAT_WakatimeIntegration_OnTimerTick);
+DEFINE_STAT(STAT_WakatimeIntegration_OnStatsTick);
+DEFINE_STAT(STAT_WakatimeIntegration_Serialize);
+DEFINE_STAT(STAT_WakatimeIntegration_OnBulkResponse);
+DEFINE_STAT(STAT_WakatimeIntegration_InstanceTick);
+
+DEFINE_STAT(STAT_WakatimeIntegration_EventsAssetAdded);
+DEFINE_STAT(STAT_WakatimeIntegration_EventsAssetRemoved);
+DEFINE_STAT(STAT_WakatimeIntegration_EventsAssetRenamed);
+DEFINE_STAT(STAT_WakatimeIntegration_EventsObjectSaved);
+DEFINE_STAT(STAT_WakatimeIntegration_EventsTransaction);
+DEFINE_STAT(STAT_WakatimeIntegration_TimerWakeups);
+DEFINE_STAT(STAT_WakatimeIntegration_PieSessions);
+DEFINE_STAT(STAT_WakatimeIntegration_BudgetOverruns);
+DEFINE_STAT(STAT_WakatimeIntegration_EventsSampledOut);
+DEFINE_STAT(STAT_WakatimeIntegration_HeartbeatsDeduplicated);
+DEFINE_STAT(STAT_WakatimeIntegration_DedupHitRate);
+DEFINE_STAT(STAT_WakatimeIntegration_FlushesRateLimited);
+DEFINE_STAT(STAT_WakatimeIntegration_EntitiesAggregated);
+DEFINE_STAT(STAT_WakatimeIntegration_HeartbeatsQueued);
+DEFINE_STAT(STAT_WakatimeIntegration_HeartbeatsSent);
+DEFINE_STAT(STAT_WakatimeIntegration_HeartbeatsFailed);
+DEFINE_STAT(STAT_WakatimeIntegration_PayloadBytes);
+DEFINE_STAT(STAT_WakatimeIntegration_HeartbeatsForwarded);
+DEFINE_STAT(STAT_WakatimeIntegration_HeartbeatsReceived);
+
+DEFINE_STAT(STAT_WakatimeIntegration_Latency100ms);
+DEFINE_STAT(STAT_WakatimeIntegration_Latency500ms);
+DEFINE_STAT(STAT_WakatimeIntegration_Latency2s);
+DEFINE_STAT(STAT_WakatimeIntegration_LatencyOver2s);
+
+TRACE_DECLARE_INT_COUNTER(WakatimeIntegration_HeartbeatsQueued, TEXT("Wakatime/Integration/HeartbeatsQueued"));
+TRACE_DECLARE_INT_COUNTER(WakatimeIntegration_HeartbeatsSent, TEXT("Wakatime/Integration/HeartbeatsSent"));
+TRACE_DECLARE_INT_COUNTER(WakatimeIntegration_HeartbeatsFailed, TEXT("Wakatime/Integration/HeartbeatsFailed"));
+TRACE_DECLARE_MEMORY_COUNTER(WakatimeIntegration_PayloadBytes, TEXT("Wakatime/Integration/PayloadBytes"));
+TRACE_DECLARE_FLOAT_COUNTER(WakatimeIntegration_RequestLatencyMs, TEXT("Wakatime/Integration/RequestLatencyMs"));
+
+void WakatimeStats::RecordRequestLatency(double Seconds)
+{
+	TRACE_COUNTER_SET(WakatimeIntegration_RequestLatencyMs, Seconds * 1000.0);
+
+	if (Seconds < 0.1) {
+		INC_DWORD_STAT(STAT_WakatimeIntegration_Latency100ms);
+	}
+	else if (Seconds < 0.5) {
+		INC_DWORD_STAT(STAT_WakatimeIntegration_Latency500ms);
+	}
+	else if (Seconds < 2.0) {
+		INC_DWORD_STAT(STAT_WakatimeIntegration_Latency2s);
+	}
+	else {
+		INC_DWORD_STAT(STAT_WakatimeIntegration_LatencyOver2s);
+	}
+}
@@ -0,0 +1,600 @@
+#include "WakatimeUploader.h"
+#include "WakatimeSettings.h"
+#include "WakatimeStats.h"
+#include "HttpModule.h"
+#include "Misc/Paths.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/DateTime.h"
+#include "Async/Async.h"
+#include "Algo/Reverse.h"
+#include "Dom/JsonObject.h"
+#include "Dom/JsonValue.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+// Number of bulk requests replaying the spool concurrently once the endpoint is reachable again
+static const int32 MaxReplayInFlight = 2;
+
+// Retry pacing after transient failures, and how long the circuit stays open once the endpoint is considered down
+static const double BackoffBaseSeconds = 2.0;
+static const double BackoffMaxSeconds = 300.0;
+static const int32 BreakerFailureThreshold = 5;
+static const double BreakerCooldownSeconds = 30.0;
+static const double BreakerMaxCooldownSeconds = 600.0;
+
+FWakatimeUploader::~FWakatimeUploader()
+{
+	if (WorkersIdle) {
+		FPlatformProcess::ReturnSynchEventToPool(WorkersIdle);
+		WorkersIdle = nullptr;
+	}
+}
+
+void FWakatimeUploader::Initialize(const FString& SpoolDirectory, FWakatimeInstanceCoordinator* InCoordinator)
+{
+	const UWakatimeSettings* Settings = GetDefault<UWakatimeSettings>();
+
+	Coordinator = InCoordinator;
+
+	Context.Initialize();
+	RefreshConnectionSettings();
+#if WITH_EDITOR
+	SettingsChangedHandle = GetMutableDefault<UWakatimeSettings>()->OnSettingChanged().AddLambda([this](UObject*, FPropertyChangedEvent&)
+	{
+		RefreshConnectionSettings();
+	});
+#endif
+
+	Backoff.Configure(BackoffBaseSeconds, BackoffMaxSeconds);
+	Breaker.Configure(BreakerFailureThreshold, BreakerCooldownSeconds, BreakerMaxCooldownSeconds);
+
+	AliveToken = MakeShared<bool, ESPMode::ThreadSafe>(true);
+	if (!WorkersIdle) {
+		WorkersIdle = FPlatformProcess::GetSynchEventFromPool(false);
+	}
+	bAcceptingEvents.store(true);
+	const FString SpoolDir = SpoolDirectory.IsEmpty() ? FPaths::ProjectSavedDir() / TEXT("Wakatime") / TEXT("Spool") : SpoolDirectory;
+	Spool.Initialize(SpoolDir, int64(Settings->WakatimeSpoolSizeMB) * 1024 * 1024);
+}
+
+void FWakatimeUploader::Shutdown()
+{
+#if WITH_EDITOR
+	if (UObjectInitialized()) {
+		GetMutableDefault<UWakatimeSettings>()->OnSettingChanged().Remove(SettingsChangedHandle);
+	}
+#endif
+
+	// Every worker has to be gone before the queues are drained here: EventQueue only allows one
+	// consumer, and a worker still forwarding or serializing would outlive the uploader otherwise.
+	// Workers read AliveToken, so it is only reset once they are done.
+	bAcceptingEvents.store(false);
+	while (OutstandingWorkers.load() > 0)
+	{
+		WorkersIdle->Wait(10);
+	}
+
+	AliveToken.Reset();
+	if (ReplayClaimTask.IsValid()) {
+		ReplayClaimTask.Wait();
+	}
+
+	if (BatchWindowHandle.IsValid()) {
+		FTSTicker::GetCoreTicker().RemoveTicker(BatchWindowHandle);
+		BatchWindowHandle.Reset();
+	}
+	if (RetryHandle.IsValid()) {
+		FTSTicker::GetCoreTicker().RemoveTicker(RetryHandle);
+		RetryHandle.Reset();
+	}
+
+	// A drain task still in the game thread queue sees the dead token and does nothing
+	bDrainScheduled.store(false);
+	FString Heartbeat;
+	while (SerializedQueue.Dequeue(Heartbeat))
+	{
+		PendingHeartbeats.Add(MoveTemp(Heartbeat));
+	}
+	FWakatimeHeartbeatEvent Event;
+	while (EventQueue.Dequeue(Event))
+	{
+		PendingHeartbeats.Add(Writer.Write(Event, Context));
+	}
+
+	// Whatever has not been acknowledged yet goes to disk and is replayed next session.
+	// Replayed heartbeats are still in their claimed segment, so they are not spooled twice.
+	Spool.Append(PendingHeartbeats);
+	PendingHeartbeats.Empty();
+	for (TPair<FHttpRequestPtr, FInFlightBatch>& Pair : InFlightBatches)
+	{
+		Pair.Key->OnProcessRequestComplete().Unbind();
+		Pair.Key->CancelRequest();
+		if (!Pair.Value.bReplay) {
+			Spool.Append(Pair.Value.Heartbeats);
+		}
+	}
+	InFlightBatches.Empty();
+	ReplayQueue.Empty();
+	Spool.Shutdown();
+}
+
+void FWakatimeUploader::Enqueue(const FWakatimeHeartbeatEvent& Event)
+{
+	// Counted before looking at the flag, so Shutdown either waits for this call or it sees the flag cleared
+	OutstandingWorkers.fetch_add(1);
+	if (bAcceptingEvents.load()) {
+		WAKATIME_COUNT(HeartbeatsQueued, 1);
+		EventQueue.Enqueue(Event);
+		if (!bWorkerScheduled.exchange(true)) {
+			Async(EAsyncExecution::ThreadPool, [this]()
+			{
+				ProcessQueue();
+				ReleaseWorker();
+			});
+			return;
+		}
+	}
+	ReleaseWorker();
+}
+
+void FWakatimeUploader::ReleaseWorker()
+{
+	if (OutstandingWorkers.fetch_sub(1) == 1 && WorkersIdle) {
+		WorkersIdle->Trigger();
+	}
+}
+
+void FWakatimeUploader::ProcessQueue()
+{
+	WAKATIME_SCOPE(Serialize);
+	TArray<FString> Serialized;
+	FWakatimeHeartbeatEvent Event;
+	for (;;)
+	{
+		while (EventQueue.Dequeue(Event))
+		{
+			Serialized.Add(Writer.Write(Event, Context));
+		}
+
+		// Anything enqueued after the flag is cleared schedules a new task; anything enqueued before
+		// it but after the last Dequeue is picked up here, unless another task already claimed it.
+		bWorkerScheduled.store(false);
+		if (EventQueue.IsEmpty() || bWorkerScheduled.exchange(true)) {
+			break;
+		}
+	}
+
+	if (Coordinator && !Coordinator->IsLeader()) {
+		const int32 Forwarded = Serialized.RemoveAll([this](const FString& Heartbeat)
+		{
+			return Coordinator->Forward(Heartbeat);
+		});
+		INC_DWORD_STAT_BY(STAT_WakatimeIntegration_HeartbeatsForwarded, Forwarded);
+		if (Serialized.Num() == 0) {
+			return;
+		}
+	}
+
+	// Batching, tickers, requests and the spool all belong to the game thread
+	for (FString& Heartbeat : Serialized)
+	{
+		SerializedQueue.Enqueue(MoveTemp(Heartbeat));
+	}
+	if (!bDrainScheduled.exchange(true)) {
+		TWeakPtr<bool, ESPMode::ThreadSafe> WeakAlive = AliveToken;
+		AsyncTask(ENamedThreads::GameThread, [this, WeakAlive]()
+		{
+			if (WeakAlive.IsValid()) {
+				DrainSerialized();
+			}
+		});
+	}
+}
+
+void FWakatimeUploader::DrainSerialized()
+{
+	bDrainScheduled.store(false);
+	FString Heartbeat;
+	while (SerializedQueue.Dequeue(Heartbeat))
+	{
+		AddPending(MoveTemp(Heartbeat));
+	}
+}
+
+void FWakatimeUploader::EnqueueSerialized(TArray<FString>&& Heartbeats)
+{
+	for (FString& Heartbeat : Heartbeats)
+	{
+		AddPending(MoveTemp(Heartbeat));
+	}
+}
+
+void FWakatimeUploader::RefreshConnectionSettings()
+{
+	const UWakatimeSettings* Settings = GetDefault<UWakatimeSettings>();
+	FString NewBulkURL = Settings->GetApiBaseURL() + TEXT("/users/current/heartbeats.bulk");
+	FString NewAuthHeader = Settings->GetAuthorizationHeader();
+
+	BulkURL = MoveTemp(NewBulkURL);
+	AuthHeader = MoveTemp(NewAuthHeader);
+}
+
+void FWakatimeUploader::AddPending(FString Heartbeat)
+{
+	const UWakatimeSettings* Settings = GetDefault<UWakatimeSettings>();
+
+	PendingHeartbeats.Add(MoveTemp(Heartbeat));
+	if (PendingHeartbeats.Num() >= Settings->WakatimeMaxBatchSize || Settings->WakatimeBatchWindow <= 0) {
+		Flush();
+		return;
+	}
+
+	if (!BatchWindowHandle.IsValid()) {
+		BatchWindowHandle = FTSTicker::GetCoreTicker().AddTicker(
+			FTickerDelegate::CreateRaw(this, &FWakatimeUploader::OnBatchWindowElapsed),
+			Settings->WakatimeBatchWindow
+		);
+	}
+}
+
+void FWakatimeUploader::Flush()
+{
+	DrainSerialized();
+	if (BatchWindowHandle.IsValid()) {
+		FTSTicker::GetCoreTicker().RemoveTicker(BatchWindowHandle);
+		BatchWindowHandle.Reset();
+	}
+	Pump();
+}
+
+void FWakatimeUploader::Tick()
+{
+	const double Now = FPlatformTime::Seconds();
+	if (!bReplayActive && Spool.HasPending() && Now >= NextAttemptTime && !Breaker.IsOpen(Now) && !IsTokenRejected()) {
+		StartSpoolReplay();
+	}
+}
+
+bool FWakatimeUploader::OnBatchWindowElapsed(float DeltaTime)
+{
+	BatchWindowHandle.Reset();
+	Pump();
+	return false;
+}
+
+void FWakatimeUploader::Pump()
+{
+	const double Now = FPlatformTime::Seconds();
+	if (PendingHeartbeats.Num() > 0 && (Breaker.IsOpen(Now) || IsTokenRejected())) {
+		// Nothing gets through until the cooldown is over or the token changes; keep the backlog on disk
+		// instead of in memory
+		Spool.Append(PendingHeartbeats);
+		PendingHeartbeats.Reset();
+		return;
+	}
+
+	// Whatever doesn't fit in the free slots stays pending and is coalesced with later heartbeats
+	const int32 MaxBatchSize = FMath::Max(GetDefault<UWakatimeSettings>()->WakatimeMaxBatchSize, 1);
+	while (PendingHeartbeats.Num() > 0 && TryAcquireSendSlot(Now))
+	{
+		const int32 Count = FMath::Min(MaxBatchSize, PendingHeartbeats.Num());
+		PostBatch(TArray<FString>(PendingHeartbeats.GetData(), Count), false);
+		PendingHeartbeats.RemoveAt(0, Count, EAllowShrinking::No);
+	}
+
+	if (PendingHeartbeats.Num() > 0) {
+		ScheduleRetry(Now);
+	}
+}
+
+bool FWakatimeUploader::TryAcquireSendSlot(double Now)
+{
+	const int32 MaxInFlight = FMath::Max(GetDefault<UWakatimeSettings>()->WakatimeMaxInFlight, 1);
+	if (Now < NextAttemptTime || InFlightBatches.Num() >= MaxInFlight || IsTokenRejected()) {
+		return false;
+	}
+	return Breaker.TryAcquire(Now);
+}
+
+void FWakatimeUploader::ScheduleRetry(double Now)
+{
+	// Only needed while backing off; a full set of in-flight requests pumps again from its responses
+	if (RetryHandle.IsValid() || NextAttemptTime <= Now) {
+		return;
+	}
+	RetryHandle = FTSTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateRaw(this, &FWakatimeUploader::OnRetryTimer),
+		static_cast<float>(NextAttemptTime - Now)
+	);
+}
+
+bool FWakatimeUploader::OnRetryTimer(float DeltaTime)
+{
+	RetryHandle.Reset();
+	Pump();
+	if (bReplayActive && !ReplaySegment.IsEmpty()) {
+		DispatchReplay();
+	}
+	return false;
+}
+
+void FWakatimeUploader::PostBatch(TArray<FString> Heartbeats, bool bReplay)
+{
+	if (Heartbeats.Num() == 0) {
+		return;
+	}
+
+	TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = FHttpModule::Get().CreateRequest();
+	Request->SetURL(BulkURL);
+	Request->SetVerb(TEXT("POST"));
+	Request->SetHeader(TEXT("Content-Type"), TEXT("application/json"));
+	Request->SetHeader(TEXT("User-Agent"), Context.UserAgent);
+	Request->SetHeader(TEXT("Authorization"), AuthHeader);
+
+	Request->SetContentAsString(TEXT("[") + FString::Join(Heartbeats, TEXT(",")) + TEXT("]"));
+	WAKATIME_COUNT(PayloadBytes, Request->GetContentLength());
+
+	Request->OnProcessRequestComplete().BindRaw(this, &FWakatimeUploader::OnBulkResponse);
+
+	FInFlightBatch& InFlight = InFlightBatches.Add(Request);
+	InFlight.Heartbeats = MoveTemp(Heartbeats);
+	InFlight.bReplay = bReplay;
+	InFlight.SentTime = FPlatformTime::Seconds();
+
+	Request->ProcessRequest();
+}
+
+bool FWakatimeUploader::IsTokenRejected() const
+{
+	return !RejectedAuthHeader.IsEmpty() && RejectedAuthHeader == AuthHeader;
+}
+
+bool FWakatimeUploader::IsRetryableCode(int32 ResponseCode)
+{
+	// Timeouts, throttling and server errors are transient; anything else would fail the same way again
+	return ResponseCode == 408 || ResponseCode == 429 || ResponseCode >= 500;
+}
+
+bool FWakatimeUploader::IsAuthCode(int32 ResponseCode)
+{
+	// The heartbeats are fine, the token isn't; they go through once it is fixed
+	return ResponseCode == 401 || ResponseCode == 403;
+}
+
+double FWakatimeUploader::GetRetryAfterSeconds(FHttpResponsePtr Response)
+{
+	if (!Response.IsValid()) {
+		return 0.0;
+	}
+
+	// Either delta-seconds or an HTTP date
+	FString RetryAfter = Response->GetHeader(TEXT("Retry-After")).TrimStartAndEnd();
+	if (RetryAfter.IsEmpty()) {
+		return 0.0;
+	}
+	if (RetryAfter.IsNumeric()) {
+		return FMath::Max(FCString::Atod(*RetryAfter), 0.0);
+	}
+	FDateTime RetryAt;
+	if (FDateTime::ParseHttpDate(RetryAfter, RetryAt)) {
+		return FMath::Max((RetryAt - FDateTime::UtcNow()).GetTotalSeconds(), 0.0);
+	}
+	return 0.0;
+}
+
+void FWakatimeUploader::RecordOutcome(bool bFailed, FHttpResponsePtr Response)
+{
+	const double Now = FPlatformTime::Seconds();
+	if (!bFailed) {
+		Breaker.RecordSuccess();
+		Backoff.Reset();
+		NextAttemptTime = 0.0;
+		return;
+	}
+
+	const bool bWasOpen = Breaker.State == EWakatimeCircuitState::Open;
+	Breaker.RecordFailure(Now);
+	NextAttemptTime = Now + Backoff.NextDelay(GetRetryAfterSeconds(Response));
+	if (!bWasOpen && Breaker.State == EWakatimeCircuitState::Open) {
+		UE_LOG(LogTemp, Warning, TEXT("Wakatime Integration: Endpoint unavailable, pausing uploads for %.0f seconds"), Breaker.OpenUntil - Now);
+	}
+}
+
+void FWakatimeUploader::OnBulkResponse(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful)
+{
+	WAKATIME_SCOPE(OnBulkResponse);
+
+	FInFlightBatch InFlight;
+	if (!InFlightBatches.RemoveAndCopyValue(Request, InFlight)) {
+		return;
+	}
+	if (InFlight.bReplay) {
+		--ReplayOutstanding;
+	}
+	const int32 BatchSize = InFlight.Heartbeats.Num();
+	WakatimeStats::RecordRequestLatency(FPlatformTime::Seconds() - InFlight.SentTime);
+
+	TArray<FString> Retry;
+	int32 Accepted = 0;
+	int32 Rejected = 0;
+	bool bRequestFailed = false;
+	bool bTokenRejected = false;
+
+	if (!bWasSuccessful || !Response.IsValid())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Wakatime Integration: Failed to establish connection to endpoint."));
+		bRequestFailed = true;
+		Retry = MoveTemp(InFlight.Heartbeats);
+	}
+	else
+	{
+		int32 ResponseCode = Response->GetResponseCode();
+		FString ResponseString = Response->GetContentAsString();
+
+		if (ResponseCode >= 200 && ResponseCode < 300)
+		{
+			// The bulk endpoint answers {"responses": [[<body>, <code>], ...]} with one entry per heartbeat.
+			// Servers that don't report per-item results accepted the whole batch.
+			TSharedPtr<FJsonObject> Root;
+			const TArray<TSharedPtr<FJsonValue>>* Results = nullptr;
+			TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(ResponseString);
+			if (FJsonSerializer::Deserialize(Reader, Root) && Root.IsValid()
+				&& Root->TryGetArrayField(TEXT("responses"), Results) && Results->Num() == InFlight.Heartbeats.Num())
+			{
+				for (int32 Index = 0; Index < Results->Num(); ++Index)
+				{
+					const TArray<TSharedPtr<FJsonValue>>* Item = nullptr;
+					int32 ItemCode = ResponseCode;
+					if ((*Results)[Index]->TryGetArray(Item) && Item->Num() >= 2) {
+						ItemCode = static_cast<int32>((*Item)[1]->AsNumber());
+					}
+
+					if (ItemCode >= 200 && ItemCode < 300) {
+						++Accepted;
+					}
+					else if (IsRetryableCode(ItemCode) || IsAuthCode(ItemCode)) {
+						bTokenRejected |= IsAuthCode(ItemCode);
+						Retry.Add(MoveTemp(InFlight.Heartbeats[Index]));
+					}
+					else {
+						++Rejected;
+					}
+				}
+			}
+			else
+			{
+				Accepted = InFlight.Heartbeats.Num();
+			}
+
+			UE_LOG(LogTemp, Log, TEXT("Wakatime Integration: Bulk heartbeats answered with code %d (%d accepted, %d rejected, %d retried)"), ResponseCode, Accepted, Rejected, Retry.Num());
+		}
+		else if (IsAuthCode(ResponseCode))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Wakatime Integration: Heartbeat failed due to invalid API token (%d). Response: %s"), ResponseCode, *ResponseString);
+			bTokenRejected = true;
+			Retry = MoveTemp(InFlight.Heartbeats);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Error, TEXT("Wakatime Integration: Heartbeat failed. Code: %d. Response: %s"), ResponseCode, *ResponseString);
+			if (IsRetryableCode(ResponseCode)) {
+				bRequestFailed = true;
+				Retry = MoveTemp(InFlight.Heartbeats);
+			}
+		}
+	}
+
+	RecordOutcome(bRequestFailed, Response);
+	WAKATIME_COUNT(HeartbeatsSent, Accepted);
+	WAKATIME_COUNT(HeartbeatsFailed, BatchSize - Accepted);
+
+	if (bTokenRejected && Request->GetHeader(TEXT("Authorization")) == AuthHeader && !IsTokenRejected()) {
+		UE_LOG(LogTemp, Warning, TEXT("Wakatime Integration: API token rejected, keeping heartbeats in the spool until it is changed"));
+		RejectedAuthHeader = AuthHeader;
+	}
+	if (Retry.Num() > 0) {
+		Spool.Append(Retry);
+	}
+	if ((bRequestFailed || bTokenRejected) && InFlight.bReplay) {
+		// The endpoint went away again or refused the token; stop replaying and put the rest of the segment back
+		AbortReplay();
+	}
+
+	if (bReplayActive) {
+		// Any finished request frees a slot the replay may be waiting for
+		if (!ReplaySegment.IsEmpty()) {
+			DispatchReplay();
+		}
+	}
+	else if (Accepted > 0 && Spool.HasPending() && !IsTokenRejected()) {
+		StartSpoolReplay();
+	}
+
+	Pump();
+}
+
+void FWakatimeUploader::StartSpoolReplay()
+{
+	bReplayActive = true;
+	bReplayAborted = false;
+
+	// Reading a segment back can mean a few megabytes of disk I/O, so it is done off the game thread.
+	// The weak token keeps the continuation from touching the uploader once it has shut down.
+	TWeakPtr<bool, ESPMode::ThreadSafe> WeakAlive = AliveToken;
+	ReplayClaimTask = Async(EAsyncExecution::ThreadPool, [this, WeakAlive]()
+	{
+		FString Segment;
+		TArray<FString> Heartbeats;
+		const bool bClaimed = Spool.ClaimSegment(Segment, Heartbeats);
+
+		AsyncTask(ENamedThreads::GameThread, [this, WeakAlive, bClaimed, Segment = MoveTemp(Segment), Heartbeats = MoveTemp(Heartbeats)]() mutable
+		{
+			if (!WeakAlive.IsValid()) {
+				return;
+			}
+			if (!bClaimed) {
+				bReplayActive = false;
+				return;
+			}
+
+			UE_LOG(LogTemp, Log, TEXT("Wakatime Integration: Replaying %d spooled heartbeat(s)"), Heartbeats.Num());
+			ReplaySegment = MoveTemp(Segment);
+			// Stored newest first so DispatchReplay can pop from the back in chronological order
+			Algo::Reverse(Heartbeats);
+			ReplayQueue = MoveTemp(Heartbeats);
+			DispatchReplay();
+		});
+	});
+}
+
+void FWakatimeUploader::DispatchReplay()
+{
+	const double Now = FPlatformTime::Seconds();
+	const int32 MaxBatchSize = FMath::Max(GetDefault<UWakatimeSettings>()->WakatimeMaxBatchSize, 1);
+	while (!bReplayAborted && ReplayOutstanding < MaxReplayInFlight && ReplayQueue.Num() > 0 && TryAcquireSendSlot(Now))
+	{
+		TArray<FString> Batch;
+		while (Batch.Num() < MaxBatchSize && ReplayQueue.Num() > 0)
+		{
+			Batch.Add(ReplayQueue.Pop(EAllowShrinking::No));
+		}
+		++ReplayOutstanding;
+		PostBatch(MoveTemp(Batch), true);
+	}
+
+	if (ReplayOutstanding == 0 && !bReplayAborted && ReplayQueue.Num() > 0) {
+		// Nothing could be sent; wait out the backoff, or give the segment back if the circuit is open
+		// or the token was refused
+		if (Breaker.IsOpen(Now) || IsTokenRejected()) {
+			AbortReplay();
+		}
+		else {
+			ScheduleRetry(Now);
+			return;
+		}
+	}
+
+	if (ReplayOutstanding > 0 || (!bReplayAborted && ReplayQueue.Num() > 0)) {
+		return;
+	}
+
+	// Every record of the segment was either accepted or appended to the spool again
+	Spool.ReleaseSegment(ReplaySegment);
+	ReplaySegment.Reset();
+	bReplayActive = false;
+
+	if (!bReplayAborted && Spool.HasPending()) {
+		StartSpoolReplay();
+	}
+}
+
+void FWakatimeUploader::AbortReplay()
+{
+	if (bReplayAborted) {
+		return;
+	}
+	bReplayAborted = true;
+	Algo::Reverse(ReplayQueue);
+	Spool.Append(ReplayQueue);
+	ReplayQueue.Empty();
+}
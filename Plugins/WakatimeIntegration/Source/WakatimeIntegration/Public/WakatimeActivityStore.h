@@ -0,0 +1,93 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FWakatimeHeartbeatEvent;
+
+/** What a report adds time up by. */
+enum class EWakatimeStoreGrouping : uint8
+{
+	Entity,
+	Folder,
+	Category,
+};
+
+/** One line of a report. */
+struct FWakatimeStoreTotal
+{
+	FString Key;
+	double Seconds = 0.0;
+	int32 Heartbeats = 0;
+};
+
+/**
+ * Local history of every heartbeat this editor produced, for reports that don't need the server.
+ *
+ * Rows (time, entity, category) are buffered and appended to Saved/Wakatime/Store as column blocks,
+ * one file per UTC month. Each block carries its own string dictionary, so processes appending to the
+ * same file never have to agree on IDs; timestamps are zigzag varint deltas and the entity and
+ * category columns are varint dictionary IDs. A fixed header with the block's time range lets queries
+ * skip blocks without decoding them, and a CRC over the payload lets them skip torn ones.
+ *
+ * Time is counted the way the WakaTime server does it: every heartbeat is credited with the gap to the
+ * next one (across all entities and processes) unless that gap is longer than the timeout.
+ * Appending is game thread only; queries only read files and may run anywhere.
+ */
+class FWakatimeActivityStore
+{
+public:
+	/** One heartbeat as the store keeps it. */
+	struct FRow
+	{
+		int64 Time = 0;
+		FName Entity;
+		bool bDebugging = false;
+	};
+
+	/** Saved/Wakatime/Store of the current project. */
+	static FString GetDefaultDirectory();
+
+	/** Start of the local calendar day DaysAgo days before today, in UTC like everything else in the store. */
+	static FDateTime GetLocalDayStart(int32 DaysAgo);
+
+	void Initialize(const FString& InDirectory);
+
+	/** Writes out whatever is buffered. */
+	void Shutdown();
+
+	/** Buffers one heartbeat; does nothing until Initialize was called. */
+	void Append(const FWakatimeHeartbeatEvent& Event);
+
+	/** Writes the buffer out if it is full or its oldest row has waited long enough. */
+	void Tick();
+
+	/** Writes the buffer out as one block. */
+	void Flush();
+
+	/** Rows not written out yet, for a query that should include them without forcing a flush. */
+	const TArray<FRow>& GetBufferedRows() const { return Rows; }
+
+	/**
+	 * Adds up time per group for heartbeats in [From, To), largest first.
+	 * Returns false if the directory holds no data for the range.
+	 */
+	static bool Query(const FString& Directory, const FDateTime& From, const FDateTime& To, EWakatimeStoreGrouping Grouping,
+		TArray<FWakatimeStoreTotal>& OutTotals, double& OutTotalSeconds, int64 TimeoutSeconds = 15 * 60);
+
+	/**
+	 * Same, with BufferedRows (a copy of GetBufferedRows) counted as if they were already written.
+	 * A row that reached the files in the meantime is only counted once.
+	 */
+	static bool Query(const FString& Directory, const FDateTime& From, const FDateTime& To, EWakatimeStoreGrouping Grouping,
+		const TArray<FRow>& BufferedRows, TArray<FWakatimeStoreTotal>& OutTotals, double& OutTotalSeconds, int64 TimeoutSeconds = 15 * 60);
+
+	static bool ParseGrouping(const FString& Text, EWakatimeStoreGrouping& OutGrouping);
+
+	/** Logs a query as a table of the Top largest groups. */
+	static void LogReport(const TArray<FWakatimeStoreTotal>& Totals, double TotalSeconds, int32 Top);
+
+private:
+	FString Directory;
+	TArray<FRow> Rows;
+	double OldestRowTime = 0.0;
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Activity recorded for one package between two heartbeat flushes. */
+struct FWakatimeEntityActivity
+{
+	FName Package;
+	int32 Additions = 0;
+	int32 Deletions = 0;
+	int32 Renames = 0;
+	int32 Saves = 0;
+	int32 Modifications = 0;
+	int64 FirstTime = 0;
+	int64 LastTime = 0;
+	bool bIsWrite = false;
+
+	bool IsEmpty() const { return Package.IsNone(); }
+
+	int32 NumEvents() const { return Additions + Deletions + Renames + Saves + Modifications; }
+
+	/** Adds Other's counters and time span to this entry; Package is left alone. */
+	void Merge(const FWakatimeEntityActivity& Other)
+	{
+		Additions += Other.Additions;
+		Deletions += Other.Deletions;
+		Renames += Other.Renames;
+		Saves += Other.Saves;
+		Modifications += Other.Modifications;
+		FirstTime = FirstTime == 0 ? Other.FirstTime : FMath::Min(FirstTime, Other.FirstTime);
+		LastTime = FMath::Max(LastTime, Other.LastTime);
+		bIsWrite |= Other.bIsWrite;
+	}
+};
+
+/**
+ * Fixed-capacity open-addressing table (linear probing) of per-package activity.
+ *
+ * Slots are allocated once and the table is kept at most half full, so recording an event is a hash
+ * and a short probe with no allocation; repeated events for the same package hit a one-entry cache
+ * and skip the probe entirely. When the entry limit is reached the least recently touched of a few
+ * sampled entries is evicted and handed back to the caller so it can be flushed early.
+ * Not thread safe; owned by the game thread.
+ */
+class FWakatimeActivityTable
+{
+public:
+	explicit FWakatimeActivityTable(int32 InMaxEntries = 1024);
+
+	/**
+	 * Returns the entry for Package, creating it if needed. If the table was full, the evicted
+	 * entry is moved into OutEvicted and true is returned.
+	 */
+	FWakatimeEntityActivity& FindOrAdd(FName Package, int64 Now, FWakatimeEntityActivity& OutEvicted, bool& bOutEvicted);
+
+	/** Moves every entry into OutEntries and empties the table, keeping its storage. */
+	void Drain(TArray<FWakatimeEntityActivity>& OutEntries);
+
+	int32 Num() const { return Count; }
+
+private:
+	uint32 HomeSlot(FName Package) const;
+	int32 PickEvictionSlot();
+	void RemoveSlot(int32 Slot);
+
+	TArray<FWakatimeEntityActivity> Slots;
+	uint32 Mask = 0;
+	uint32 HashShift = 0;
+	int32 MaxEntries = 0;
+	int32 Count = 0;
+	int32 EvictionCursor = 0;
+
+	FName CachedPackage;
+	int32 CachedSlot = INDEX_NONE;
+};
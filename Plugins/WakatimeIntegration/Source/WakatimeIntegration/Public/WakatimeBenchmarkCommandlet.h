@@ -0,0 +1,36 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "WakatimeBenchmarkCommandlet.generated.h"
+
+class FWakatimeIntegrationModule;
+class UPackage;
+
+/**
+ * End-to-end benchmark of the plugin against a loopback stand-in server.
+ *
+ * Feeds synthetic asset and save events through FWakatimeIntegrationModule, lets the uploader deliver
+ * them to FWakatimeStandInServer (optionally with injected latency, errors and dropped responses) and
+ * writes heartbeats delivered, payload bytes, end-to-end latency and game-thread time per event to a
+ * JSON file, so results can be compared between plugin versions. Returns non-zero if any entity was
+ * not delivered or was delivered twice, other than resent after its response was dropped. Injected
+ * 401s renew the token, so heartbeats held for a refused token are expected to arrive as well.
+ *
+ * UnrealEditor-Cmd <Project> -run=WakatimeBenchmark [-Events=2000] [-Rate=200] [-Port=8731]
+ *     [-LatencyMs=0] [-Rate401=0] [-Rate429=0] [-Rate500=0] [-DropRate=0] [-DrainTimeout=120] [-Output=<file>]
+ */
+UCLASS()
+class UWakatimeBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UWakatimeBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	void InjectEvent(FWakatimeIntegrationModule& Module, int32 Index, UPackage* SavedPackage);
+	static void PumpEngine(float DeltaTime);
+};
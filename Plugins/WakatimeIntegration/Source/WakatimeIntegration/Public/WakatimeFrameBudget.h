@@ -0,0 +1,51 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Keeps the plugin's own game-thread time per frame under a budget.
+ *
+ * Every editor callback and the stats ticker open an FScope; only the outermost scope on the game
+ * thread counts. The heartbeat timer doesn't, since its housekeeping isn't what the budget protects.
+ * Once the time spent in one frame goes over the budget the plugin is degraded: callers let only one
+ * event in SampleRate through to the per-package bookkeeping, leave flushing to the heartbeat timer
+ * and send heartbeats without line counts.
+ * It goes back to full fidelity after RecoveryFrames frames in a row stayed under half the budget;
+ * frames without any callback count as quiet.
+ */
+class FWakatimeFrameBudget
+{
+public:
+	class FScope
+	{
+	public:
+		explicit FScope(FWakatimeFrameBudget& InBudget);
+		~FScope();
+
+	private:
+		FWakatimeFrameBudget& Budget;
+		uint64 StartCycles = 0;
+		bool bCounted = false;
+	};
+
+	/** A budget of 0 turns the guard off. */
+	void Configure(double BudgetSeconds, int32 InSampleRate);
+
+	bool IsDegraded() const { return bDegraded; }
+
+	/** Whether to fully record this event: always at full fidelity, one in SampleRate while degraded. */
+	bool ShouldSample();
+
+private:
+	void AdvanceFrame();
+	void SetDegraded(bool bInDegraded);
+
+	uint64 BudgetCycles = 0;
+	uint32 SampleRate = 1;
+	uint32 SampleCounter = 0;
+	uint64 Frame = 0;
+	uint64 FrameCycles = 0;
+	uint64 QuietFrames = 0;
+	int32 Depth = 0;
+	bool bDegraded = false;
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** What the game thread hands over for one heartbeat. Plain data; serialization happens elsewhere. */
+struct FWakatimeHeartbeatEvent
+{
+	FName Entity;
+	int64 Time = 0;
+	int32 Lines = 0;
+	bool bIsWrite = false;
+
+	/** Sent while Play-In-Editor runs; reported with the debugging category. */
+	bool bDebugging = false;
+};
+
+/** The parts of a heartbeat that never change during a session, resolved and escaped once. */
+struct FWakatimeHeartbeatContext
+{
+	void Initialize();
+
+	FString UserAgent;
+
+	/** Pre-escaped ,"key":value pairs appended to every heartbeat object. */
+	FString StaticFields;
+};
+
+/**
+ * Serializes heartbeat events to JSON into a buffer that is reused between calls, so steady-state
+ * serialization doesn't allocate. Not thread safe; each thread that serializes needs its own writer.
+ */
+class FWakatimeHeartbeatWriter
+{
+public:
+	FWakatimeHeartbeatWriter();
+
+	/** Returns the JSON object for Event. The reference is valid until the next call. */
+	const FString& Write(const FWakatimeHeartbeatEvent& Event, const FWakatimeHeartbeatContext& Context);
+
+	/** Appends Value as a quoted JSON string, escaping quotes, backslashes and control characters. */
+	static void AppendQuoted(FString& Out, FStringView Value);
+
+private:
+	FString Buffer;
+	FString EntityBuffer;
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/LruCache.h"
+
+struct FWakatimeHeartbeatEvent;
+
+/**
+ * Drops heartbeats the server would discard anyway.
+ *
+ * The WakaTime server ignores a heartbeat for an entity it got another one for within the last two
+ * minutes, unless is_write changed. The most recently sent entities are kept in a small LRU cache
+ * keyed by entity and category, so redundant heartbeats never reach the store, the serializer or the
+ * network. Heartbeats carrying line changes always go through. Game thread only.
+ */
+class FWakatimeHeartbeatDedup
+{
+public:
+	explicit FWakatimeHeartbeatDedup(int32 InMaxEntries = 256);
+
+	/** Whether Event is worth sending; remembers it if so. */
+	bool ShouldSend(const FWakatimeHeartbeatEvent& Event);
+
+	/** Share of heartbeats dropped so far, 0 to 1. */
+	double GetHitRate() const { return Lookups > 0 ? static_cast<double>(Hits) / Lookups : 0.0; }
+
+private:
+	struct FKey
+	{
+		FName Entity;
+		bool bDebugging = false;
+
+		bool operator==(const FKey& Other) const { return Entity == Other.Entity && bDebugging == Other.bDebugging; }
+		friend uint32 GetTypeHash(const FKey& Key) { return HashCombine(GetTypeHash(Key.Entity), Key.bDebugging ? 1u : 0u); }
+	};
+
+	struct FSent
+	{
+		int64 Time = 0;
+		bool bIsWrite = false;
+	};
+
+	TLruCache<FKey, FSent> Sent;
+	uint64 Lookups = 0;
+	uint64 Hits = 0;
+};
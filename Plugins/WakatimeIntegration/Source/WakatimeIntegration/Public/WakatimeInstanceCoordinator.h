@@ -0,0 +1,71 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/PlatformMemory.h"
+#include <atomic>
+
+class IFileHandle;
+struct FWakatimeSharedHeader;
+struct FWakatimeSharedSlot;
+
+/**
+ * Lets several editor processes of the same user share one uploader.
+ *
+ * The first process to open the leader lockfile exclusively becomes the leader and owns a named
+ * shared memory segment holding a bounded lock-free ring (one producer slot per heartbeat, claimed
+ * with a CAS on the write index and published with a per-slot sequence number). Every other process
+ * is a follower: its uploader serializes heartbeats as usual but pushes them into the ring instead of
+ * sending them, and the leader drains the ring once a second into its own batches. The leader also
+ * publishes today's total so followers don't have to poll the stats endpoint either.
+ *
+ * The lock is released by the OS when the leader exits or crashes; followers notice a missing or dead
+ * leader on their next tick and elect a new one. A follower that can't reach a ring (full, segment
+ * unavailable, heartbeat too large) just uploads by itself.
+ */
+class FWakatimeInstanceCoordinator
+{
+public:
+	/** Receives heartbeats forwarded by other processes, on the game thread. */
+	typedef TFunction<void(TArray<FString>&& Heartbeats)> FOnForwarded;
+
+	void Initialize(FOnForwarded InOnForwarded);
+
+	/** Hands whatever is still in the ring to OnForwarded and gives up leadership. */
+	void Shutdown();
+
+	bool IsLeader() const { return bLeader.load(std::memory_order_acquire); }
+
+	/** Follower side: pushes one serialized heartbeat to the leader. Safe to call from any thread. */
+	bool Forward(const FString& Heartbeat);
+
+	/** Leader side: shares today's server total with the followers. */
+	void PublishTodaySeconds(double Seconds, int32 DayOfYear);
+
+	/** Follower side: today's server total as last published by the leader, if it is for DayOfYear. */
+	bool GetTodaySeconds(int32 DayOfYear, double& OutSeconds) const;
+
+private:
+	bool OnTick(float DeltaTime);
+	void Elect();
+	bool Attach(bool bCreate);
+	void Detach();
+	void Drain();
+	FWakatimeSharedSlot* GetSlot(uint64 Index) const;
+
+	FOnForwarded OnForwarded;
+	FString LockFilePath;
+	FString RegionName;
+	IFileHandle* LockHandle = nullptr;
+	std::atomic<bool> bLeader = false;
+	FTSTicker::FDelegateHandle TickHandle;
+
+	/** Guards the mapping itself; the ring inside it is lock-free. */
+	mutable FCriticalSection MappingLock;
+	FPlatformMemory::FSharedMemoryRegion* Region = nullptr;
+	FWakatimeSharedHeader* Header = nullptr;
+
+	/** Leader only: when the oldest slot was first seen claimed but not yet published. */
+	double StalledSince = 0.0;
+};
@@ -8,14 +8,28 @@
 #include "Containers/Ticker.h"
 #include "Interfaces/IHttpRequest.h"
 #include "Interfaces/IHttpResponse.h"
+#include "WakatimeUploader.h"
+#include "WakatimeActivityTable.h"
+#include "WakatimeRateLimiter.h"
+#include "WakatimeInstanceCoordinator.h"
+#include "WakatimeFrameBudget.h"
+#include "WakatimeActivityStore.h"
+#include "WakatimeHeartbeatDedup.h"
+#include <atomic>
 
 struct FAssetData;
+struct FTransactionContext;
+enum class ETransactionStateEventType : uint8;
 class UBlueprint;
 class UObject;
 class UWakatimeSettings;
+class IConsoleObject;
+class SWidget;
 
 class FWakatimeIntegrationModule : public IModuleInterface
 {
+	friend class UWakatimeBenchmarkCommandlet;
+
 public:
 	/** IModuleInterface implementation */
 	virtual void StartupModule() override;
@@ -23,34 +37,99 @@ public:
 
 private:
 	bool OnTimerTick(float DeltaTime);
+	void OnAssetRegistryFilesLoaded();
+	void FlushIfAllowed(EWakatimeEventClass EventClass);
 	void OnAssetAdded(const FAssetData& AssetData);
 	void OnAssetRemoved(const FAssetData& AssetData);
 	void OnAssetRenamed(const FAssetData& AssetData, const FString& OldPath);
 	void OnObjectSaved(UObject* SavedObject);
-	void OnObjectModified(UObject* ModifiedObject);
+	void BindEditorHooks();
+	void UnbindEditorHooks();
+	void OnPostPieStarted(bool bIsSimulating);
+	void OnPrePieEnded(bool bIsSimulating);
+	void SendDebuggingHeartbeat();
+	void OnTransactionStateChanged(const FTransactionContext& TransactionContext, ETransactionStateEventType TransactionState);
+	void SampleUserActivity();
+	void OnUserInteraction(double InteractionTime);
+	void OnApplicationActivationChanged(bool bIsActive);
+	void ScheduleTimerTick(float Delay);
+	void ConfigureFrameBudget();
 	void MarkActivity();
 	void SendHeartbeat();
+	void EnqueueHeartbeat(const FWakatimeHeartbeatEvent& Event);
+	void BuildHeartbeats(TArray<FWakatimeHeartbeatEvent>& OutEvents);
+	FWakatimeHeartbeatEvent MakeHeartbeatEvent(const FWakatimeEntityActivity& Activity) const;
+	FWakatimeEntityActivity* RecordActivity(FName Package);
+	void AddToOverflow(const FWakatimeEntityActivity& Activity);
 	void FetchTodayStats();
 	void OnStatsHttpResponse(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful);
+	void ComputeStoreFallback();
 	void RegisterToolbarExtension();
 	TSharedRef<SWidget> GenerateToolbarWidget();
 	FText GetTodayTimeText() const;
+	bool OnStatsTick(float DeltaTime);
+	void UpdateTodayTimeText();
 	int64 GetCurrentTime();
-	void OnHttpResponse(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful);
-
-	FCriticalSection DataLock;
-	bool Dirty = false;
-	int32 DeleteOperations = 0;
-	int32 SaveOperations = 0;
-	int32 RenameOperations = 0;
-	int32 AddOperations = 0;
-	int64 LastAssetPushTime = -1;
-	int64 LastActivityTime = 0;
-	int64 SaveDebounce = 2;
-	FName LastSavedName = FName(TEXT("None"));
+	void SyncClock();
+	void BenchmarkActivity(const TArray<FString>& Args);
+	void ReportActivity(const TArray<FString>& Args);
+
+	// Written from editor callbacks, so these are plain atomics.
+	// Per-package counters live in ActivityTable, which only the game thread touches.
+	std::atomic<bool> Dirty = false;
+	std::atomic<int64> LastActivityTime = 0;
+	std::atomic<int64> ClockOffset = 0;
+	FWakatimeTokenBucket EventBuckets[static_cast<int32>(EWakatimeEventClass::Count)];
+	FWakatimeActivityTable ActivityTable;
+	FName LastEntity = FName(TEXT("None"));
+
+	// Entities past the per-flush cap (or evicted from a full table) are summed here and sent as
+	// one heartbeat on OverflowFolder, the deepest folder they all share
+	FWakatimeEntityActivity OverflowActivity;
+	FString OverflowFolder;
+	int32 OverflowEntities = 0;
+
+	// Game-thread time spent in the callbacks below; while over budget the hot ones are sampled
+	FWakatimeFrameBudget FrameBudget;
 	FTSTicker::FDelegateHandle TimerHandle;
+
+	// The heartbeat timer backs off while the user is idle; the next input brings it straight back.
+	// LastSeenInteractionTime is in FPlatformTime seconds, like Slate's own bookkeeping.
+	float TimerDelay = 0.0f;
+	bool bTimerBackedOff = false;
+	double LastSeenInteractionTime = 0.0;
+	FDelegateHandle UserInteractionHandle;
+	FDelegateHandle ActivationChangedHandle;
+
+	// While Play-In-Editor runs the editor hooks are unbound and the heartbeat timer only reports
+	// debugging time on PieEntity, the map being played
+	bool bInPie = false;
+	FName PieEntity;
 	FTSTicker::FDelegateHandle StatsTimerHandle;
 
-	FString TodayTimeFormatted = TEXT("--:--");
+	FWakatimeUploader Uploader;
+	FWakatimeActivityStore ActivityStore;
+	FWakatimeHeartbeatDedup HeartbeatDedup;
+	FWakatimeInstanceCoordinator Coordinator;
+	bool bCoordinatorActive = false;
+	IConsoleObject* BenchmarkCommand = nullptr;
+	IConsoleObject* ReportCommand = nullptr;
+
+	// Today's total as last reported by the server plus the activity observed locally since then.
+	// Refetched at a low rate with conditional requests; the toolbar only reads TodayTimeFormatted.
+	FHttpRequestPtr StatsRequest;
+	FString StatsETag;
+	FString StatsLastModified;
+	bool bStatsLegacyPath = false;
+	double NextStatsFetchTime = 0.0;
+	double ServerTodaySeconds = 0.0;
+	bool bHaveServerToday = false;
+	// The local-history fallback for an offline start runs once a day, on a pool thread
+	bool bStoreFallbackComputed = false;
+	TSharedPtr<bool, ESPMode::ThreadSafe> AliveToken;
+	double LocalTodaySeconds = 0.0;
+	int32 StatsDayOfYear = -1;
+	int32 DisplayedMinutes = -1;
+	FText TodayTimeFormatted = INVTEXT("--:--");
 	TSharedPtr<class FUICommandList> PluginCommands;
 };
\ No newline at end of file
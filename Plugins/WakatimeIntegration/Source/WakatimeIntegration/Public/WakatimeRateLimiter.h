@@ -0,0 +1,47 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Classes of editor events that are rate limited independently of each other. */
+enum class EWakatimeEventClass : uint8
+{
+	AssetAdded,
+	AssetRemoved,
+	AssetRenamed,
+	ObjectSaved,
+	Count
+};
+
+/**
+ * Classic token bucket: holds up to Capacity tokens and refills at RatePerSecond.
+ * A burst of events can go through immediately, after which they are admitted at the refill rate.
+ */
+struct FWakatimeTokenBucket
+{
+	void Configure(double InRatePerSecond, double InCapacity)
+	{
+		RatePerSecond = FMath::Max(InRatePerSecond, 0.0);
+		Capacity = FMath::Max(InCapacity, 1.0);
+		Tokens = Capacity;
+		LastRefill = -1.0;
+	}
+
+	bool TryConsume(double Now)
+	{
+		if (LastRefill >= 0.0) {
+			Tokens = FMath::Min(Capacity, Tokens + (Now - LastRefill) * RatePerSecond);
+		}
+		LastRefill = Now;
+
+		if (Tokens < 1.0) {
+			return false;
+		}
+		Tokens -= 1.0;
+		return true;
+	}
+
+	double RatePerSecond = 0.0;
+	double Capacity = 1.0;
+	double Tokens = 1.0;
+	double LastRefill = -1.0;
+};
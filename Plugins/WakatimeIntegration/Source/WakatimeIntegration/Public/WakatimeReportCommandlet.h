@@ -0,0 +1,25 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "WakatimeReportCommandlet.generated.h"
+
+/**
+ * Offline report from the local activity store, e.g. for a daily summary on a build machine.
+ *
+ * Logs time per asset, folder or category for a date range and optionally writes it as CSV. A running
+ * editor buffers up to 15 minutes of heartbeats before writing them to the store.
+ *
+ * UnrealEditor-Cmd <Project> -run=WakatimeReport [-Days=1 | -From=<ISO 8601> [-To=<ISO 8601>]]
+ *     [-GroupBy=asset|folder|category] [-Top=20] [-Timeout=900] [-Store=<dir>] [-Output=<file.csv>]
+ */
+UCLASS()
+class UWakatimeReportCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UWakatimeReportCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -21,6 +21,45 @@ public:
 	UPROPERTY(Config, EditAnywhere, Category = "Wakatime Integration", meta = (DisplayName = "API Endpoint URL", Tooltip = "Something like this, no trailing slash: https://wakahost.example.com/api/waka/v1"))
 	FString WakatimeEndpoint;
 
+	UPROPERTY(Config, EditAnywhere, Category = "Wakatime Integration", meta = (DisplayName = "Offline Spool Size (MB)", Tooltip = "Heartbeats that fail to send are kept on disk under Saved/Wakatime and replayed once the endpoint is reachable again", ClampMin = "1", ClampMax = "1024"))
+	int32 WakatimeSpoolSizeMB;
+
+	UPROPERTY(Config, EditAnywhere, Category = "Wakatime Integration", meta = (DisplayName = "Batch Window (s)", Tooltip = "Heartbeats are collected for this long and uploaded together to the bulk endpoint. 0 sends right away", ClampMin = "0", ClampMax = "120"))
+	int32 WakatimeBatchWindow;
+
+	UPROPERTY(Config, EditAnywhere, Category = "Wakatime Integration", meta = (DisplayName = "Max Heartbeats Per Request", ClampMin = "1", ClampMax = "100"))
+	int32 WakatimeMaxBatchSize;
+
+	UPROPERTY(Config, EditAnywhere, Category = "Wakatime Integration", meta = (DisplayName = "Max Requests In Flight", Tooltip = "Upload requests allowed at the same time. Heartbeats arriving while all are busy join the next batch", ClampMin = "1", ClampMax = "16"))
+	int32 WakatimeMaxInFlight;
+
+	UPROPERTY(Config, EditAnywhere, Category = "Wakatime Integration", meta = (DisplayName = "Event Flushes Per Minute", Tooltip = "How often each kind of asset event (add, remove, rename, save) may flush heartbeats immediately. Events over the limit are still recorded and sent with the next heartbeat", ClampMin = "0", ClampMax = "600"))
+	float WakatimeEventFlushRate;
+
+	UPROPERTY(Config, EditAnywhere, Category = "Wakatime Integration", meta = (DisplayName = "Event Flush Burst", ClampMin = "1", ClampMax = "100"))
+	int32 WakatimeEventFlushBurst;
+
+	UPROPERTY(Config, EditAnywhere, Category = "Wakatime Integration", meta = (DisplayName = "Max Heartbeats Per Flush", Tooltip = "Bulk operations touching more assets than this send the busiest ones individually and fold the rest into one heartbeat on their common folder", ClampMin = "1", ClampMax = "100"))
+	int32 WakatimeMaxHeartbeatsPerFlush;
+
+	UPROPERTY(Config, EditAnywhere, Category = "Wakatime Integration", meta = (DisplayName = "Today Stats Refresh (s)", Tooltip = "How often the toolbar re-fetches today's total from the server. Locally observed activity is added in between", ClampMin = "60", ClampMax = "3600"))
+	int32 WakatimeStatsRefreshInterval;
+
+	UPROPERTY(Config, EditAnywhere, Category = "Wakatime Integration", meta = (DisplayName = "Share Uploads Between Editors", Tooltip = "When several editors run on this machine, one of them uploads for all and the others hand their heartbeats to it. Takes effect after a restart"))
+	bool bWakatimeShareUploads;
+
+	UPROPERTY(Config, EditAnywhere, Category = "Wakatime Integration", meta = (DisplayName = "Frame Budget (us)", Tooltip = "Game-thread time per frame the plugin may spend in its editor callbacks. Over it, events are sampled and flushed with the next heartbeat until the load drops. 0 turns this off", ClampMin = "0", ClampMax = "10000"))
+	float WakatimeFrameBudgetMicroseconds;
+
+	UPROPERTY(Config, EditAnywhere, Category = "Wakatime Integration", meta = (DisplayName = "Over Budget Sample Rate", Tooltip = "While over the frame budget, one editor event in this many is recorded per asset; the others only count as activity", ClampMin = "1", ClampMax = "1000"))
+	int32 WakatimeDegradedSampleRate;
+
+	/** Configured endpoint with the default filled in and no trailing slash. */
+	FString GetApiBaseURL() const;
+
+	/** Value for the Authorization header of API requests. */
+	FString GetAuthorizationHeader() const;
+
 	virtual FName GetContainerName() const override { return TEXT("Editor"); }
 	virtual FName GetCategoryName() const override { return TEXT("Plugins"); }
 	virtual FName GetSectionName() const override { return TEXT("Wakatime_Settings"); }
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+class IFileHandle;
+
+/**
+ * Bounded, append-only on-disk queue for heartbeats that could not be delivered.
+ *
+ * The spool is a directory of segment files named after the process that wrote them and a
+ * sequence number, so several editors can share one directory. Every record is one line of the form
+ * "<crc32> <json>\n" and is flushed as soon as it is written, so a crash loses at most the
+ * line being written; torn or corrupted lines are skipped when the segment is read back.
+ * Once the total size exceeds the budget the oldest segments are dropped.
+ *
+ * Replay works a segment at a time: ClaimSegment renames the oldest segment so new appends
+ * never touch it, and ReleaseSegment deletes it once every record has either been accepted
+ * by the endpoint or appended to the spool again. Initialize adopts segments, claimed or not,
+ * whose owning process is no longer running (editor crashed mid-replay or quit with a backlog);
+ * segments of editors that are still open are left to them.
+ */
+class FWakatimeSpool
+{
+public:
+	~FWakatimeSpool();
+
+	void Initialize(const FString& InDirectory, int64 InMaxBytes);
+	void Shutdown();
+
+	/** Appends heartbeat payloads to the active segment. Safe to call from any thread. */
+	void Append(const TArray<FString>& Heartbeats);
+	void Append(const FString& Heartbeat);
+
+	bool HasPending() const;
+
+	/** Claims the oldest segment for replay. Returns false if nothing is pending. */
+	bool ClaimSegment(FString& OutSegment, TArray<FString>& OutHeartbeats);
+
+	/** Deletes a segment previously returned by ClaimSegment. */
+	void ReleaseSegment(const FString& Segment);
+
+private:
+	FString MakeSegmentPath(int32 Sequence, const TCHAR* Extension) const;
+	void AdoptSegments();
+	bool OpenActiveSegment();
+	void CloseActiveSegment();
+	void EnforceBudget();
+	static void ReadRecords(const FString& Path, TArray<FString>& OutHeartbeats);
+
+	mutable FCriticalSection Lock;
+	FString Directory;
+	int64 MaxBytes = 0;
+	int64 SegmentBytes = 0;
+	int64 TotalBytes = 0;
+
+	uint32 ProcessId = 0;
+
+	/** Sealed segments of this process waiting for replay, oldest first. */
+	TArray<int32> PendingSegments;
+	TMap<int32, int64> SegmentSizes;
+
+	IFileHandle* ActiveHandle = nullptr;
+	int32 ActiveSequence = 0;
+	int64 ActiveBytes = 0;
+	int32 NextSequence = 1;
+};
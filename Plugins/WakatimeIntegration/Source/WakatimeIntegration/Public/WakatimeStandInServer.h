@@ -0,0 +1,86 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "HttpRouteHandle.h"
+#include "HttpResultCallback.h"
+#include "HttpServerConstants.h"
+
+class IHttpRouter;
+struct FHttpServerRequest;
+struct FHttpServerResponse;
+
+/** Faults the stand-in server injects, each drawn independently per request. */
+struct FWakatimeStandInFaults
+{
+	/** Added before every response. */
+	float LatencyMs = 0.0f;
+
+	float Rate401 = 0.0f;
+	float Rate429 = 0.0f;
+	float Rate500 = 0.0f;
+
+	/** The request is accepted and recorded, but no response is ever sent; the client has to time out. */
+	float DropRate = 0.0f;
+
+	/** Sent with injected 429s. */
+	int32 RetryAfterSeconds = 1;
+};
+
+/**
+ * Minimal loopback stand-in for the Wakatime API, used by the benchmark commandlet. Serves the single
+ * and bulk heartbeat endpoints and status_bar/today (with ETag support), injects the configured faults
+ * and records what arrived.
+ */
+class FWakatimeStandInServer
+{
+public:
+	~FWakatimeStandInServer();
+
+	bool Start(uint32 InPort, const FWakatimeStandInFaults& InFaults);
+	void Stop();
+
+	/** Base URL to configure as the plugin endpoint. */
+	FString GetEndpoint() const;
+
+	int32 Requests = 0;
+	int32 HeartbeatsReceived = 0;
+	int32 Duplicates = 0;
+
+	/** Duplicates of heartbeats whose response was dropped; the client can't know they arrived, so these are expected. */
+	int32 DuplicatesFromDrops = 0;
+	int64 PayloadBytes = 0;
+	int32 StatsRequests = 0;
+	int32 StatsNotModified = 0;
+	TMap<int32, int32> ResponseCodes;
+
+	/** FPlatformTime::Seconds() at which each entity was first received. */
+	TMap<FString, double> FirstSeen;
+
+	/** Entities turned away at least once by an injected 401. */
+	TSet<FString> Rejected401;
+
+private:
+	struct FDelayedResponse
+	{
+		double ReadyTime = 0.0;
+		TUniquePtr<FHttpServerResponse> Response;
+		FHttpResultCallback OnComplete;
+	};
+
+	bool HandleHeartbeats(const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete);
+	bool HandleStats(const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete);
+	bool InjectFault(const FHttpResultCallback& OnComplete, EHttpServerResponseCodes* OutCode = nullptr);
+	void Respond(TUniquePtr<FHttpServerResponse> Response, const FHttpResultCallback& OnComplete);
+	bool OnTick(float DeltaTime);
+
+	uint32 Port = 0;
+	FWakatimeStandInFaults Faults;
+	TSharedPtr<IHttpRouter> Router;
+	TArray<FHttpRouteHandle> Routes;
+	TArray<FDelayedResponse> Delayed;
+	TArray<FHttpResultCallback> Dropped;
+	TSet<FString> DroppedEntities;
+	FTSTicker::FDelegateHandle TickHandle;
+	int32 StatsVersion = 1;
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Trace/Trace.h"
+
+/**
+ * Instrumentation for `stat Wakatime` and Unreal Insights. Enable the channel with
+ * `-trace=default,WakatimeIntegration` (or `Trace.Enable WakatimeIntegration`) to get a CPU scope per
+ * callback; the counters show up as Insights counter tracks whenever the counters channel is on.
+ */
+DECLARE_STATS_GROUP(TEXT("Wakatime"), STATGROUP_Wakatime, STATCAT_Advanced);
+
+UE_TRACE_CHANNEL_EXTERN(WakatimeIntegrationChannel)
+
+// Time spent inside each callback
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Integration OnAssetAdded"), STAT_WakatimeIntegration_OnAssetAdded, STATGROUP_Wakatime, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Integration OnAssetRemoved"), STAT_WakatimeIntegration_OnAssetRemoved, STATGROUP_Wakatime, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Integration OnAssetRenamed"), STAT_WakatimeIntegration_OnAssetRenamed, STATGROUP_Wakatime, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Integration OnObjectSaved"), STAT_WakatimeIntegration_OnObjectSaved, STATGROUP_Wakatime, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Integration OnTransaction"), STAT_WakatimeIntegration_OnTransaction, STATGROUP_Wakatime, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Integration OnTimerTick"), STAT_WakatimeIntegration_OnTimerTick, STATGROUP_Wakatime, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Integration OnStatsTick"), STAT_WakatimeIntegration_OnStatsTick, STATGROUP_Wakatime, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Integration Serialize (worker)"), STAT_WakatimeIntegration_Serialize, STATGROUP_Wakatime, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Integration OnBulkResponse"), STAT_WakatimeIntegration_OnBulkResponse, STATGROUP_Wakatime, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Integration InstanceTick"), STAT_WakatimeIntegration_InstanceTick, STATGROUP_Wakatime, );
+
+// Totals since startup
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Integration Events AssetAdded"), STAT_WakatimeIntegration_EventsAssetAdded, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Integration Events AssetRemoved"), STAT_WakatimeIntegration_EventsAssetRemoved, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Integration Events AssetRenamed"), STAT_WakatimeIntegration_EventsAssetRenamed, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Integration Events ObjectSaved"), STAT_WakatimeIntegration_EventsObjectSaved, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Integration Events Transaction"), STAT_WakatimeIntegration_EventsTransaction, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Integration Timer Wakeups"), STAT_WakatimeIntegration_TimerWakeups, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Integration PIE Sessions"), STAT_WakatimeIntegration_PieSessions, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Integration Frames Over Budget"), STAT_WakatimeIntegration_BudgetOverruns, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Integration Events Sampled Out"), STAT_WakatimeIntegration_EventsSampledOut, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Integration Heartbeats Deduplicated"), STAT_WakatimeIntegration_HeartbeatsDeduplicated, STATGROUP_Wakatime, );
+DECLARE_FLOAT_ACCUMULATOR_STAT_EXTERN(TEXT("Integration Dedup Hit Rate (%)"), STAT_WakatimeIntegration_DedupHitRate, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Integration Flushes Rate Limited"), STAT_WakatimeIntegration_FlushesRateLimited, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Integration Entities Aggregated"), STAT_WakatimeIntegration_EntitiesAggregated, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Integration Heartbeats Queued"), STAT_WakatimeIntegration_HeartbeatsQueued, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Integration Heartbeats Sent"), STAT_WakatimeIntegration_HeartbeatsSent, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Integration Heartbeats Failed"), STAT_WakatimeIntegration_HeartbeatsFailed, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Integration Payload Bytes"), STAT_WakatimeIntegration_PayloadBytes, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Integration Heartbeats Forwarded"), STAT_WakatimeIntegration_HeartbeatsForwarded, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Integration Heartbeats Received"), STAT_WakatimeIntegration_HeartbeatsReceived, STATGROUP_Wakatime, );
+
+// Request latency histogram
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Integration Latency < 100 ms"), STAT_WakatimeIntegration_Latency100ms, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Integration Latency < 500 ms"), STAT_WakatimeIntegration_Latency500ms, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Integration Latency < 2 s"), STAT_WakatimeIntegration_Latency2s, STATGROUP_Wakatime, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Integration Latency >= 2 s"), STAT_WakatimeIntegration_LatencyOver2s, STATGROUP_Wakatime, );
+
+TRACE_DECLARE_INT_COUNTER_EXTERN(WakatimeIntegration_HeartbeatsQueued);
+TRACE_DECLARE_INT_COUNTER_EXTERN(WakatimeIntegration_HeartbeatsSent);
+TRACE_DECLARE_INT_COUNTER_EXTERN(WakatimeIntegration_HeartbeatsFailed);
+TRACE_DECLARE_MEMORY_COUNTER_EXTERN(WakatimeIntegration_PayloadBytes);
+TRACE_DECLARE_FLOAT_COUNTER_EXTERN(WakatimeIntegration_RequestLatencyMs);
+
+/** CPU scope on the plugin's trace channel plus the matching cycle stat. */
+#define WAKATIME_SCOPE(Name) \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL_STR("WakatimeIntegration::" #Name, WakatimeIntegrationChannel); \
+	SCOPE_CYCLE_COUNTER(STAT_WakatimeIntegration_##Name)
+
+/** Bumps a total in both the stat group and the Insights counter track. */
+#define WAKATIME_COUNT(Name, Amount) \
+	INC_DWORD_STAT_BY(STAT_WakatimeIntegration_##Name, Amount); \
+	TRACE_COUNTER_ADD(WakatimeIntegration_##Name, Amount)
+
+namespace WakatimeStats
+{
+	/** Files one completed request into the latency histogram. */
+	void RecordRequestLatency(double Seconds);
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Exponential backoff with full jitter: the n-th consecutive failure waits a random time in
+ * [0, min(Max, Base * 2^n)], so clients that failed together don't come back together.
+ * A server-provided Retry-After is treated as a lower bound.
+ */
+struct FWakatimeBackoff
+{
+	void Configure(double InBaseSeconds, double InMaxSeconds)
+	{
+		BaseSeconds = FMath::Max(InBaseSeconds, 0.0);
+		MaxSeconds = FMath::Max(InMaxSeconds, BaseSeconds);
+		Reset();
+	}
+
+	double NextDelay(double RetryAfterSeconds)
+	{
+		const double Ceiling = FMath::Min(MaxSeconds, BaseSeconds * FMath::Pow(2.0, static_cast<double>(Attempt)));
+		Attempt = FMath::Min(Attempt + 1, 30);
+		return FMath::Max(FMath::FRandRange(0.0, Ceiling), RetryAfterSeconds);
+	}
+
+	void Reset()
+	{
+		Attempt = 0;
+	}
+
+	double BaseSeconds = 2.0;
+	double MaxSeconds = 300.0;
+	int32 Attempt = 0;
+};
+
+enum class EWakatimeCircuitState : uint8
+{
+	Closed,
+	Open,
+	HalfOpen
+};
+
+/**
+ * Stops sending after a run of consecutive failures. Once the cooldown has passed a single probe
+ * request is let through; its outcome either closes the circuit or opens it again with a longer cooldown.
+ */
+struct FWakatimeCircuitBreaker
+{
+	void Configure(int32 InFailureThreshold, double InCooldownSeconds, double InMaxCooldownSeconds)
+	{
+		FailureThreshold = FMath::Max(InFailureThreshold, 1);
+		BaseCooldown = FMath::Max(InCooldownSeconds, 0.0);
+		MaxCooldown = FMath::Max(InMaxCooldownSeconds, BaseCooldown);
+		Cooldown = BaseCooldown;
+		State = EWakatimeCircuitState::Closed;
+		ConsecutiveFailures = 0;
+		bProbeInFlight = false;
+	}
+
+	/** True if a request may be sent now. In the half-open state this hands out the one probe. */
+	bool TryAcquire(double Now)
+	{
+		if (State == EWakatimeCircuitState::Open && Now >= OpenUntil) {
+			State = EWakatimeCircuitState::HalfOpen;
+			bProbeInFlight = false;
+		}
+
+		switch (State)
+		{
+		case EWakatimeCircuitState::Closed:
+			return true;
+		case EWakatimeCircuitState::HalfOpen:
+			if (bProbeInFlight) {
+				return false;
+			}
+			bProbeInFlight = true;
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	/** The endpoint answered; it may still have rejected the request, but it is up. */
+	void RecordSuccess()
+	{
+		State = EWakatimeCircuitState::Closed;
+		ConsecutiveFailures = 0;
+		Cooldown = BaseCooldown;
+		bProbeInFlight = false;
+	}
+
+	void RecordFailure(double Now)
+	{
+		++ConsecutiveFailures;
+		if (State == EWakatimeCircuitState::HalfOpen) {
+			Cooldown = FMath::Min(Cooldown * 2.0, MaxCooldown);
+		}
+		if (State == EWakatimeCircuitState::HalfOpen || ConsecutiveFailures >= FailureThreshold) {
+			State = EWakatimeCircuitState::Open;
+			OpenUntil = Now + Cooldown;
+		}
+		bProbeInFlight = false;
+	}
+
+	bool IsOpen(double Now) const
+	{
+		return State == EWakatimeCircuitState::Open && Now < OpenUntil;
+	}
+
+	EWakatimeCircuitState State = EWakatimeCircuitState::Closed;
+	int32 FailureThreshold = 5;
+	int32 ConsecutiveFailures = 0;
+	double BaseCooldown = 30.0;
+	double MaxCooldown = 600.0;
+	double Cooldown = 30.0;
+	double OpenUntil = 0.0;
+	bool bProbeInFlight = false;
+};
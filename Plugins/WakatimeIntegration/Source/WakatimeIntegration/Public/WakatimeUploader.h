@@ -0,0 +1,126 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Containers/Queue.h"
+#include "Interfaces/IHttpRequest.h"
+#include "Interfaces/IHttpResponse.h"
+#include "Async/Future.h"
+#include "HAL/Event.h"
+#include "WakatimeSpool.h"
+#include "WakatimeHeartbeat.h"
+#include "WakatimeTransportPolicy.h"
+#include "WakatimeInstanceCoordinator.h"
+#include <atomic>
+
+/**
+ * Collects heartbeats and uploads them to the bulk heartbeats endpoint.
+ *
+ * Producers only push a small event onto a lock-free queue; a background task serializes the
+ * queued events with a reused writer and hands the JSON back to the game thread through a second
+ * lock-free queue, so JSON building never runs on the game thread. Everything after that
+ * (batching, tickers, requests, the spool) is game thread only and needs no lock. Heartbeats are
+ * held for the configured batch window (or until a full batch is ready) and then sent as JSON
+ * arrays of at most the configured batch size. The server answers with one result per heartbeat; transient failures go to the on-disk
+ * spool and are replayed, in bulk as well, once the endpoint accepts requests again.
+ *
+ * At most the configured number of requests is in flight; heartbeats arriving meanwhile are
+ * coalesced into the pending batch. Failures back off exponentially with jitter (honoring
+ * Retry-After), and a circuit breaker stops sending altogether while the endpoint is down. A token
+ * the server refuses (401/403) keeps everything in the spool until the token setting changes.
+ *
+ * With a coordinator, a process that isn't the leader forwards its serialized heartbeats to the
+ * leader instead of uploading them, and only falls back to uploading when that fails.
+ */
+class FWakatimeUploader
+{
+public:
+	~FWakatimeUploader();
+
+	/** Defaults to Saved/Wakatime/Spool; the benchmark commandlet points this elsewhere. */
+	void Initialize(const FString& SpoolDirectory = FString(), FWakatimeInstanceCoordinator* InCoordinator = nullptr);
+	void Shutdown();
+
+	/** Queues one heartbeat. Cheap and safe to call from any thread; ignored after Shutdown. */
+	void Enqueue(const FWakatimeHeartbeatEvent& Event);
+
+	/** Queues heartbeats another editor already serialized and forwarded to this one. Game thread only. */
+	void EnqueueSerialized(TArray<FString>&& Heartbeats);
+
+	/** Sends everything serialized so far right away. Game thread only. */
+	void Flush();
+
+	/** Periodic housekeeping from the module ticker: replays the spool when the endpoint is up. */
+	void Tick();
+
+private:
+	struct FInFlightBatch
+	{
+		TArray<FString> Heartbeats;
+		bool bReplay = false;
+		double SentTime = 0.0;
+	};
+
+	void ProcessQueue();
+	void ReleaseWorker();
+	void DrainSerialized();
+	void RefreshConnectionSettings();
+	void AddPending(FString Heartbeat);
+	bool OnBatchWindowElapsed(float DeltaTime);
+	void Pump();
+	bool TryAcquireSendSlot(double Now);
+	void ScheduleRetry(double Now);
+	bool OnRetryTimer(float DeltaTime);
+	void RecordOutcome(bool bFailed, FHttpResponsePtr Response);
+	void PostBatch(TArray<FString> Heartbeats, bool bReplay);
+	void OnBulkResponse(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful);
+	void StartSpoolReplay();
+	void DispatchReplay();
+	void AbortReplay();
+	bool IsTokenRejected() const;
+	static bool IsRetryableCode(int32 ResponseCode);
+	static bool IsAuthCode(int32 ResponseCode);
+	static double GetRetryAfterSeconds(FHttpResponsePtr Response);
+
+	TQueue<FWakatimeHeartbeatEvent, EQueueMode::Mpsc> EventQueue;
+	std::atomic<bool> bWorkerScheduled = false;
+	std::atomic<bool> bAcceptingEvents = false;
+
+	/** Workers and Enqueue calls that have not returned yet; Shutdown waits on WorkersIdle until this is 0. */
+	std::atomic<int32> OutstandingWorkers = 0;
+	FEvent* WorkersIdle = nullptr;
+
+	/** Serialized by the workers, consumed on the game thread. */
+	TQueue<FString, EQueueMode::Mpsc> SerializedQueue;
+	std::atomic<bool> bDrainScheduled = false;
+
+	FWakatimeHeartbeatContext Context;
+	FWakatimeHeartbeatWriter Writer;
+	FWakatimeInstanceCoordinator* Coordinator = nullptr;
+
+	// Everything below is game thread only
+	FString BulkURL;
+	FString AuthHeader;
+	FDelegateHandle SettingsChangedHandle;
+
+	/** The Authorization header the server last refused; nothing is sent while it is still the current one. */
+	FString RejectedAuthHeader;
+
+	TArray<FString> PendingHeartbeats;
+	FTSTicker::FDelegateHandle BatchWindowHandle;
+
+	FWakatimeBackoff Backoff;
+	FWakatimeCircuitBreaker Breaker;
+	double NextAttemptTime = 0.0;
+	FTSTicker::FDelegateHandle RetryHandle;
+
+	FWakatimeSpool Spool;
+	TMap<FHttpRequestPtr, FInFlightBatch> InFlightBatches;
+	TArray<FString> ReplayQueue;
+	FString ReplaySegment;
+	int32 ReplayOutstanding = 0;
+	bool bReplayActive = false;
+	bool bReplayAborted = false;
+	TFuture<void> ReplayClaimTask;
+	TSharedPtr<bool, ESPMode::ThreadSafe> AliveToken;
+};
@@ -25,9 +25,14 @@ public class WakatimeIntegration : ModuleRules
 				"UnrealEd",
 				"AssetRegistry",
 				"HTTP",
+				"HTTPServer",
+				"Projects",
 				"Json",
 				"JsonUtilities",
 				"DeveloperSettings",
+				"Slate",
+				"SlateCore",
+				"ToolMenus",
                 
             }
 			);